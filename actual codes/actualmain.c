@@ -6,6 +6,7 @@ DifficultyStats hardStats = {0, 0, 0, 0};
 
 Difficulty currentDifficulty = MEDIUM; // Default difficulty
 Cell grid[GRID_SIZE][GRID_SIZE];
+Board gameBoard; // mirrors grid with per-line counters for O(1) win and draw checks
 PlayerTurn currentPlayerTurn = PLAYER_X_TURN;
 bool gameOver = false;
 Cell winner = EMPTY;
@@ -23,8 +24,147 @@ float buttonVibrationOffset = 0.0f;
 float vibrationSpeed = 15.0f;
 float vibrationAmount = 2.0f;
 
-int main(void)
+const BoardGeometry *classicGeometry = NULL;
+Tablebase endgameTablebase;
+
+EngineType currentEngine = ENGINE_MINIMAX;
+Engine aiEngine;
+
+PnsSolver positionSolver; // exact verdicts for the dataset and the AI Analysis screen
+PnsResult openingVerdict;
+int turningPoint = -1;    // index of the move that changed the last game's result, -1 if none
+long long analysisNodes = 0;
+
+FramePacer framePacer; // draws a frame only when input, an animation or the AI needs one
+
+GameDb gameLog;           // every finished game, for "--games"
+uint64_t gameStartedAt = 0;
+
+// Static screen content, cached in render textures. The versions are bumped
+// whenever what the layers show changes: the board and turn, or the numbers
+// on the AI Analysis page.
+unsigned boardVersion = 0;
+unsigned statsVersion = 0;
+Layer boardLayer;
+Layer menuLayer;
+Layer howToPlayLayer;
+Layer analysisLayer;
+
+bool showProfiler = false; // frame timing overlay, toggled with F3
+
+// Buttons of every screen, and the one under the mouse this frame
+WidgetTable screenWidgets[HOW_TO_PLAY + 1];
+const Widget *hotWidget = NULL;
+
+static const Widget menuWidgets[] = {
+    { WIDGET_SINGLE_PLAYER, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + BUTTON_HEIGHT + 20, BUTTON_WIDTH, BUTTON_HEIGHT }, "Single Player", 20, WIDGET_VIBRATES },
+    { WIDGET_TWO_PLAYERS, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2, BUTTON_WIDTH, BUTTON_HEIGHT }, "Two Players", 20, WIDGET_VIBRATES },
+    { WIDGET_ANALYSIS, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 3, BUTTON_WIDTH, BUTTON_HEIGHT }, "View AI Analysis", 20, WIDGET_VIBRATES },
+    { WIDGET_HOW_TO_PLAY, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 4, BUTTON_WIDTH, BUTTON_HEIGHT }, "How to Play", 20, WIDGET_VIBRATES },
+};
+
+static const Widget difficultyWidgets[] = {
+    { WIDGET_EASY, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2, BUTTON_WIDTH, BUTTON_HEIGHT }, "Easy", 20, WIDGET_VIBRATES },
+    { WIDGET_MEDIUM, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + BUTTON_HEIGHT + 20, BUTTON_WIDTH, BUTTON_HEIGHT }, "Medium", 20, WIDGET_VIBRATES },
+    { WIDGET_HARD, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2, BUTTON_WIDTH, BUTTON_HEIGHT }, "Hard", 20, WIDGET_VIBRATES },
+    { WIDGET_ENGINE, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 3, BUTTON_WIDTH, BUTTON_HEIGHT }, NULL, 20, 0 }, // label follows currentEngine
+    { WIDGET_BACK, { 20, 10, SCREEN_WIDTH/6, 30 }, "Back", 20, 0 },
+};
+
+static const Widget gameWidgets[] = {
+    { WIDGET_QUIT, { SCREEN_WIDTH - 80, 10, 70, 30 }, "Quit", 20, 0 },
+    { WIDGET_UNDO, { 10, 10, 70, 30 }, "Undo", 20, 0 },
+    { WIDGET_REDO, { 90, 10, 70, 30 }, "Redo", 20, 0 },
+};
+
+static const Widget gameOverWidgets[] = {
+    { WIDGET_RETRY, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + 40, BUTTON_WIDTH, BUTTON_HEIGHT }, "Retry", 20, 0 },
+    { WIDGET_BACK_TO_MENU, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT/2 + 100, BUTTON_WIDTH, BUTTON_HEIGHT }, "Back to Menu", 20, 0 },
+};
+
+static const Widget analysisWidgets[] = {
+    { WIDGET_BACK, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT - BUTTON_HEIGHT - 10, BUTTON_WIDTH, BUTTON_HEIGHT }, "Back to Menu", 20, 0 },
+};
+
+static const Widget howToPlayWidgets[] = {
+    { WIDGET_BACK, { SCREEN_WIDTH/2 - BUTTON_WIDTH/2, SCREEN_HEIGHT - BUTTON_HEIGHT - 15, BUTTON_WIDTH, BUTTON_HEIGHT }, "Back", 18, 0 },
+};
+
+int main(int argc, char **argv)
 {
+    // Options ahead of any mode: "--threads N[:pin]" sizes the shared scheduler,
+    // "--trace <file>" records trace events and writes them to file on exit,
+    // "--record <file>" saves the game's input for "--replay"
+    const char *recordPath = NULL;
+    while (argc > 2) {
+        if (strcmp(argv[1], "--threads") == 0) {
+            int threads = 0;
+            char pin[8] = "";
+            sscanf(argv[2], "%d:%7s", &threads, pin);
+            SchedulerConfigureShared(threads, strcmp(pin, "pin") == 0);
+        } else if (strcmp(argv[1], "--trace") == 0) {
+            TraceStart(argv[2]);
+            TraceThreadName("main");
+        } else if (strcmp(argv[1], "--record") == 0) {
+            recordPath = argv[2];
+        } else {
+            break;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    // Headless engine-vs-engine matches, no window needed
+    if (argc > 1 && strcmp(argv[1], "--arena") == 0) {
+        LoadEndgameTablebase();
+        int status = ArenaMain(argc - 2, argv + 2, classicGeometry, &endgameTablebase);
+        TablebaseClose(&endgameTablebase);
+        return status;
+    }
+
+    // Bulk scoring of a position file, e.g. a whole dataset
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        LoadEndgameTablebase();
+        int status = BatchMain(argc - 2, argv + 2, &endgameTablebase);
+        TablebaseClose(&endgameTablebase);
+        return status;
+    }
+
+    // Text protocol for tournament managers and test harnesses
+    if (argc > 1 && strcmp(argv[1], "--protocol") == 0) {
+        LoadEndgameTablebase();
+        int status = ProtocolMain(argc - 2, argv + 2, &endgameTablebase);
+        TablebaseClose(&endgameTablebase);
+        return status;
+    }
+
+    // Many games at once over a local socket, and a client to load it with
+    if (argc > 1 && strcmp(argv[1], "--server") == 0) {
+        LoadEndgameTablebase();
+        int status = ServerMain(argc - 2, argv + 2, &endgameTablebase);
+        TablebaseClose(&endgameTablebase);
+        return status;
+    }
+    if (argc > 1 && strcmp(argv[1], "--loadgen") == 0) {
+        return LoadGenMain(argc - 2, argv + 2);
+    }
+
+    // Plays a recorded session back without a window and times its frames
+    if (argc > 1 && strcmp(argv[1], "--replay") == 0) {
+        return ReplayMain(argc - 2, argv + 2);
+    }
+
+    // Where each difficulty loses, from the games played so far
+    if (argc > 1 && strcmp(argv[1], "--games") == 0) {
+        return GameDbMain(argc - 2, argv + 2);
+    }
+
+    // Regenerates the opening book compiled in from book_data.h
+    if (argc > 1 && strcmp(argv[1], "--build-book") == 0) {
+        return BookMain(argc - 2, argv + 2);
+    }
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tic-Tac-Toe");
     customFont = LoadFont("sourgummy.ttf");  // Replace with your font file
 
@@ -32,114 +172,52 @@ int main(void)
     float weights[FEATURES + 1] = {0}; // +1 for the bias term
     TrainLinearRegression(weights, 0.01, 1000); // Train the model
     EvaluateLinearRegression(weights); // Evaluate the model
+    LearnerStart(weights, 0.01f, false); // and keep training it on the games played from here
+
+    // Both random generators are seeded here so a recording can replay the session
+    uint64_t engineSeed = (uint64_t)time(NULL);
+    uint32_t menuSeed = (uint32_t)engineSeed;
+    SetRandomSeed(menuSeed);
+
+    GameDbOpen(&gameLog, GAME_DB_DEFAULT_FILE);
+
+    // Results against the AI carry over from earlier sessions
+    if (StatsStoreOpen(STATS_DEFAULT_FILE)) {
+        DifficultyStats totals[HARD + 1];
+        StatsStoreTotals(totals);
+        easyStats = totals[EASY];
+        mediumStats = totals[MEDIUM];
+        hardStats = totals[HARD];
+    }
 
-    while (!WindowShouldClose())
-    {
-        if (gameState == MENU) {
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                Vector2 mousePos = GetMousePosition();
-                // Single Player button
-                if (mousePos.x >= SCREEN_WIDTH/2 - 100 && mousePos.x <= SCREEN_WIDTH/2 + 100 &&
-                    mousePos.y >= SCREEN_HEIGHT/2 + 60 && mousePos.y <= SCREEN_HEIGHT/2 + 100) {
-                    isTwoPlayer = false;
-                    gameState = DIFFICULTY_SELECT;  // go to difficulty selection instead of game
-                }
-                // Two Player button
-                else if (mousePos.x >= SCREEN_WIDTH/2 - 100 && mousePos.x <= SCREEN_WIDTH/2 + 100 &&
-                        mousePos.y >= SCREEN_HEIGHT/2 + 120 && mousePos.y <= SCREEN_HEIGHT/2 + 160) {
-                    isTwoPlayer = true;
-                    gameState = GAME;
-                    InitGame();
-                }
-                // AI Analysis button
-                else if (mousePos.x >= SCREEN_WIDTH/2 - 100 && mousePos.x <= SCREEN_WIDTH/2 + 100 &&
-                    mousePos.y >= SCREEN_HEIGHT/2 + 180 && mousePos.y <= SCREEN_HEIGHT/2 + 220) {
-                    LoadAndEvaluateDataset();
-                    gameState = AI_ANALYSIS;  // Change to AI Analysis state instead of just displaying stats
-                }
-                // How To Play button
-                else if (mousePos.x >= SCREEN_WIDTH/2 - 100 && mousePos.x <= SCREEN_WIDTH/2 + 100 &&
-                        mousePos.y >= SCREEN_HEIGHT/2 + 240 && mousePos.y <= SCREEN_HEIGHT/2 + 280) {
-                    gameState = HOW_TO_PLAY;
-                }
-            }
-        }
-        else if (gameState == GAME)
-        {
-            UpdateGame();
-        }
-        else if (gameState == GAME_OVER)
-        {
-            UpdateGameOver();
-        }
-        else if (gameState == DIFFICULTY_SELECT) {
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                Vector2 mousePos = GetMousePosition();
+    LoadEndgameTablebase();
+    EngineConfig aiConfig = EngineConfigDefault(currentEngine, currentDifficulty);
+    EngineInit(&aiEngine, &aiConfig, &endgameTablebase, engineSeed);
+    PnsInit(&positionSolver, PNS_DEFAULT_NODES, PNS_DEFAULT_TABLE_BITS);
 
-                // Back button
-                if (mousePos.x >= 20 && mousePos.x <= SCREEN_WIDTH/6 && mousePos.y >= 10 && mousePos.y <= 40) {
-                    gameState = MENU;
-                }
+    SetTargetFPS(FRAME_TARGET_FPS);
+    FramePacerInit(&framePacer);
 
-                if (mousePos.x >= SCREEN_WIDTH/2 - BUTTON_WIDTH/2 && 
-                    mousePos.x <= SCREEN_WIDTH/2 + BUTTON_WIDTH/2) {
-                    // easy button
-                    if (mousePos.y >= SCREEN_HEIGHT/2 && 
-                        mousePos.y <= SCREEN_HEIGHT/2 + BUTTON_HEIGHT) {
-                        currentDifficulty = EASY;
-                        gameState = GAME;
-                        InitGame();
-                    }
-                    // medium button
-                    else if (mousePos.y >= SCREEN_HEIGHT/2 + BUTTON_HEIGHT + 20 && 
-                             mousePos.y <= SCREEN_HEIGHT/2 + BUTTON_HEIGHT * 2 + 20) {
-                        currentDifficulty = MEDIUM;
-                        gameState = GAME;
-                        InitGame();
-                    }
-                    // hard button
-                    else if (mousePos.y >= SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2 && 
-                             mousePos.y <= SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2 + BUTTON_HEIGHT) {
-                        currentDifficulty = HARD;
-                        gameState = GAME;
-                        InitGame();
-                    }
-                }
-            }
-        }
-        else if (gameState == AI_ANALYSIS) {
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                Vector2 mousePos = GetMousePosition();
-                Rectangle backBtn = {
-                    SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-                    SCREEN_HEIGHT - BUTTON_HEIGHT - 20,
-                    BUTTON_WIDTH,
-                    BUTTON_HEIGHT
-                };
-                if (CheckCollisionPointRec(mousePos, backBtn)) {
-                    gameState = MENU;
-                }
-            }
-        }
+    InitWidgets();
+    bool cursorPointing = false;
+    if (recordPath != NULL && ReplayRecordStart(recordPath, engineSeed, menuSeed)) {
+        printf("Recording input to %s\n", recordPath);
+    }
 
-        else if (gameState == HOW_TO_PLAY) {
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                Vector2 mousePos = GetMousePosition();
-                Rectangle backBtn = {
-                    SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-                    SCREEN_HEIGHT - BUTTON_HEIGHT - 20,
-                    BUTTON_WIDTH,
-                    BUTTON_HEIGHT
-                };
+    while (!WindowShouldClose())
+    {
+        ProfilerBeginFrame();
+        InputBeginFrame();
+        UpdateFrame();
 
-                if (CheckCollisionPointRec(mousePos, backBtn)) {
-                    gameState = MENU;
-                }
-            }
+        if ((hotWidget != NULL) != cursorPointing) {
+            cursorPointing = hotWidget != NULL;
+            SetMouseCursor(cursorPointing ? MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
         }
 
         BeginDrawing();
         ClearBackground(RAYWHITE);
+        ProfilerPush(PROFILE_DRAW);
 
         switch(gameState) {
             case MENU:
@@ -162,10 +240,30 @@ int main(void)
                 DrawHowToPlay();
                 break;
         }
+        ProfilerPop();
+
+        // The overlay comes after the frame's sample so it doesn't measure itself
+        ProfilerEndFrame(framePacer.waiting);
+        if (showProfiler) DrawProfilerOverlay();
 
+        // With nothing moving, EndDrawing blocks until the next input event
+        if (FramePacerEnd(&framePacer)) EnableEventWaiting();
+        else DisableEventWaiting();
         EndDrawing();
     }
 
+    ReplayRecordStop();
+    StatsStoreClose();
+    GameDbClose(&gameLog);
+    LearnerStop();
+    FramePacerReport(&framePacer);
+    LayerUnload(&boardLayer);
+    LayerUnload(&menuLayer);
+    LayerUnload(&howToPlayLayer);
+    LayerUnload(&analysisLayer);
+    EngineFree(&aiEngine);
+    PnsFree(&positionSolver);
+    TablebaseClose(&endgameTablebase);
     UnloadFont(customFont);
     CloseWindow();
     return 0;
@@ -175,85 +273,218 @@ void DrawHowToPlay() {
     const int titleFontSize = 40;
     const int textFontSize = 18;
     const int padding = 15;
-    
-    // Title
-    const char* title = "How to Play";
-    Vector2 titlePos = {
-        SCREEN_WIDTH/2 - MeasureTextEx(customFont, title, titleFontSize, 1).x/2,
-        40
-    };
-    DrawTextEx(customFont, title, titlePos, titleFontSize, 1, BLACK);
-
-    // Instructions
-    const char* instructions[] = {
-        "Single Player:",
-        "- Play against AI with 3 difficulty levels",
-        "- Click empty cells to place your X mark",
-        "- Try to get 3 X's in a row (horizontally, vertically or diagonally) to win!",
-        "",
-        "Two Players:",
-        "- Play against a friend locally",
-        "- Players take turns placing X's and O's",
-        "- First to get 3 in a row (horizontally, vertically or diagonally) wins!",
-        "",
-        "Controls:",
-        "- Use your mouse to click cells and buttons",
-        "- Click 'Quit' to return to menu during the game"
-    };
-
-    int currentY = 120;
-    for (int i = 0; i < 13; i++) {
-        Vector2 textPos = { padding * 2, currentY };
-        Color textColor = (i == 0 || i == 5 || i == 10) ? DARKBLUE : BLACK;
-        DrawTextEx(customFont, instructions[i], textPos, textFontSize, 1, textColor);
-        currentY += textFontSize + padding;
+
+    // Title and instructions never change, so they are drawn once
+    if (LayerBegin(&howToPlayLayer, SCREEN_WIDTH, SCREEN_HEIGHT, 0)) {
+        ClearBackground(RAYWHITE);
+
+        // Title
+        const char* title = "How to Play";
+        Vector2 titlePos = {
+            SCREEN_WIDTH/2 - LayoutMeasureTextEx(customFont, title, titleFontSize, 1).x/2,
+            40
+        };
+        LayoutDrawTextEx(customFont, title, titlePos, titleFontSize, 1, BLACK);
+
+        // Instructions
+        const char* instructions[] = {
+            "Single Player:",
+            "- Play against AI with 3 difficulty levels",
+            "- Click empty cells to place your X mark",
+            "- Try to get 3 X's in a row (horizontally, vertically or diagonally) to win!",
+            "",
+            "Two Players:",
+            "- Play against a friend locally",
+            "- Players take turns placing X's and O's",
+            "- First to get 3 in a row (horizontally, vertically or diagonally) wins!",
+            "",
+            "Controls:",
+            "- Use your mouse to click cells and buttons",
+            "- Click 'Quit' to return to menu during the game",
+            "- Click 'Undo' or 'Redo' to take back or replay moves"
+        };
+
+        int currentY = 120;
+        for (int i = 0; i < 14; i++) {
+            Vector2 textPos = { padding * 2, currentY };
+            Color textColor = (i == 0 || i == 5 || i == 10) ? DARKBLUE : BLACK;
+            LayoutDrawTextEx(customFont, instructions[i], textPos, textFontSize, 1, textColor);
+            currentY += textFontSize + padding;
+        }
+
+        LayerEnd(&howToPlayLayer);
     }
+    LayerDraw(&howToPlayLayer, (Vector2){ 0, 0 });
 
     // Back button
-    Rectangle backBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT - BUTTON_HEIGHT - padding,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-
-    Vector2 mousePos = GetMousePosition();
-    bool isHovering = CheckCollisionPointRec(mousePos, backBtn);
-    
-    DrawButton(backBtn, "Back", textFontSize, isHovering);
-    SetMouseCursor(isHovering ? MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+    DrawWidgets(&screenWidgets[HOW_TO_PLAY]);
 }
 
-void UpdateGameOver() {
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-        Vector2 mousePos = GetMousePosition();
-        
-        // Retry Button
-        Rectangle retryBtn = {
-            SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-            SCREEN_HEIGHT/2 + 40,
-            BUTTON_WIDTH,
-            BUTTON_HEIGHT
-        };
-        
-        // Back to Menu Button
-        Rectangle menuBtn = {
-            SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-            SCREEN_HEIGHT/2 + 100,
-            BUTTON_WIDTH,
-            BUTTON_HEIGHT
-        };
-        
-        if (CheckCollisionPointRec(mousePos, menuBtn)) {
-            printf("Back to Menu clicked\n"); // Debug print
+void InitWidgets() {
+    WidgetTableInit(&screenWidgets[MENU], menuWidgets, sizeof(menuWidgets) / sizeof(menuWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+    WidgetTableInit(&screenWidgets[DIFFICULTY_SELECT], difficultyWidgets, sizeof(difficultyWidgets) / sizeof(difficultyWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+    WidgetTableInit(&screenWidgets[GAME], gameWidgets, sizeof(gameWidgets) / sizeof(gameWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+    WidgetTableInit(&screenWidgets[GAME_OVER], gameOverWidgets, sizeof(gameOverWidgets) / sizeof(gameOverWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+    WidgetTableInit(&screenWidgets[AI_ANALYSIS], analysisWidgets, sizeof(analysisWidgets) / sizeof(analysisWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+    WidgetTableInit(&screenWidgets[HOW_TO_PLAY], howToPlayWidgets, sizeof(howToPlayWidgets) / sizeof(howToPlayWidgets[0]), SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+// What a click on each button does
+void ActivateWidget(const Widget *widget) {
+    switch (widget->id) {
+        case WIDGET_SINGLE_PLAYER:
+            isTwoPlayer = false;
+            gameState = DIFFICULTY_SELECT;  // go to difficulty selection instead of game
+            break;
+        case WIDGET_TWO_PLAYERS:
+            isTwoPlayer = true;
+            gameState = GAME;
+            InitGame();
+            break;
+        case WIDGET_ANALYSIS:
+            PROFILE_SCOPE(PROFILE_ANALYSIS) {
+                LoadAndEvaluateDataset();
+                AnalyzeLastGame();
+            }
+            gameState = AI_ANALYSIS;  // Change to AI Analysis state instead of just displaying stats
+            break;
+        case WIDGET_HOW_TO_PLAY:
+            gameState = HOW_TO_PLAY;
+            break;
+        case WIDGET_EASY:
+        case WIDGET_MEDIUM:
+        case WIDGET_HARD:
+            currentDifficulty = widget->id == WIDGET_EASY ? EASY : widget->id == WIDGET_MEDIUM ? MEDIUM : HARD;
+            gameState = GAME;
+            InitGame();
+            break;
+        case WIDGET_ENGINE:
+            currentEngine = (currentEngine == ENGINE_MINIMAX) ? ENGINE_MCTS : ENGINE_MINIMAX;
+            break;
+        case WIDGET_QUIT:
+        case WIDGET_BACK:
             gameState = MENU;
-            InitGame();  // Reset the game state
-        } else if (CheckCollisionPointRec(mousePos, retryBtn)) {
+            break;
+        case WIDGET_UNDO:
+            UndoMove();
+            break;
+        case WIDGET_REDO:
+            RedoMove();
+            break;
+        case WIDGET_RETRY:
             printf("Retry clicked\n"); // Debug print
             gameState = GAME;
             InitGame();  // Reset the game state for a new game
-        }
+            break;
+        case WIDGET_BACK_TO_MENU:
+            printf("Back to Menu clicked\n"); // Debug print
+            gameState = MENU;
+            InitGame();  // Reset the game state
+            break;
+    }
+}
+
+// Everything a frame does besides drawing: keys, hit testing and the game's
+// update. It only reads input through the replay layer, so a recorded session
+// runs through it without a window.
+void UpdateFrame()
+{
+    ProfilerPush(PROFILE_INPUT);
+
+    // F3 shows frame timings, F4 saves the recent ones, F5 writes the event trace so far
+    if (InputKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+    if (InputKeyPressed(KEY_F4)) {
+        if (ProfilerWriteTrace(PROFILER_DEFAULT_FILE)) printf("Frame trace written to %s\n", PROFILER_DEFAULT_FILE);
+        else printf("Error writing %s!\n", PROFILER_DEFAULT_FILE);
+    }
+    if (InputKeyPressed(KEY_F5) && TraceEnabled()) TraceFlush();
+
+    // One hit test per frame, shared by the input handlers and the draw functions
+    GameState shownState = gameState;
+    hotWidget = WidgetTableHit(&screenWidgets[gameState], InputMouse());
+
+    if (gameState == GAME)
+    {
+        UpdateGame();
+    }
+    else if (InputClicked() && hotWidget != NULL)
+    {
+        ActivateWidget(hotWidget);
+    }
+
+    // A click that changed screens is drawn with the new screen's widgets
+    if (gameState != shownState) {
+        hotWidget = WidgetTableHit(&screenWidgets[gameState], InputMouse());
+    }
+
+    // The AI moves during the next frame's update, so that frame can't wait for a click
+    if (gameState == GAME && !isTwoPlayer && !gameOver && currentPlayerTurn == PLAYER_O_TURN) {
+        FrameRequestAnimation(&framePacer);
+    }
+    ProfilerPop();
+}
+
+// Entry point for "--replay <session> [max-p99-us]": runs a recorded session
+// through UpdateFrame as fast as it goes, with nothing drawn, and reports the
+// frame times. With a budget, a p99 over it fails the run.
+int ReplayMain(int argc, char **argv)
+{
+    ReplayHeader header;
+    if (argc < 1) {
+        printf("Usage: [--trace <file>] --replay <session> [max-p99-us]\n");
+        return 1;
+    }
+    if (!ReplayLoad(argv[0], &header)) return 1;
+    double budgetUs = argc > 1 ? atof(argv[1]) : 0.0;
+
+    // The same starting model as the game, paced so each game gets the model it had when recorded
+    float weights[FEATURES + 1] = {0};
+    TrainLinearRegression(weights, 0.01, 1000);
+    LearnerStart(weights, 0.01f, true);
+
+    SetRandomSeed(header.menuSeed);
+    LoadEndgameTablebase();
+    EngineConfig aiConfig = EngineConfigDefault(currentEngine, currentDifficulty);
+    EngineInit(&aiEngine, &aiConfig, &endgameTablebase, header.engineSeed);
+    PnsInit(&positionSolver, PNS_DEFAULT_NODES, PNS_DEFAULT_TABLE_BITS);
+    InitWidgets();
+
+    static LatencyHistogram frameTimes;
+    long long slowestFrame = 0;
+    uint64_t startNs = TimerNowNs();
+    while (InputBeginFrame()) {
+        uint64_t frameStart = TimerNowNs();
+        ProfilerBeginFrame();
+        UpdateFrame();
+        ProfilerEndFrame(false);
+
+        uint64_t ns = TimerNowNs() - frameStart;
+        if (ns > frameTimes.maxNs) slowestFrame = (long long)frameTimes.count;
+        LatencyRecord(&frameTimes, ns);
     }
+    double seconds = (TimerNowNs() - startNs) / 1e9;
+
+    printf("\nReplay: %lld frames (%.2fs as played) in %.3fs\n", (long long)frameTimes.count, ReplaySeconds(), seconds);
+    printf("  Frame time (us): mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f (frame %lld)\n",
+           frameTimes.count ? frameTimes.totalNs / 1000.0 / frameTimes.count : 0.0,
+           LatencyPercentile(&frameTimes, 50) / 1000.0, LatencyPercentile(&frameTimes, 90) / 1000.0,
+           LatencyPercentile(&frameTimes, 99) / 1000.0, frameTimes.maxNs / 1000.0, slowestFrame);
+    printf("  AI results: easy %d/%d/%d, medium %d/%d/%d, hard %d/%d/%d (wins/losses/draws)\n",
+           easyStats.wins, easyStats.losses, easyStats.draws, mediumStats.wins, mediumStats.losses, mediumStats.draws,
+           hardStats.wins, hardStats.losses, hardStats.draws);
+
+    ReplayFree();
+    LearnerStop();
+    EngineFree(&aiEngine);
+    PnsFree(&positionSolver);
+    TablebaseClose(&endgameTablebase);
+
+    double p99Us = LatencyPercentile(&frameTimes, 99) / 1000.0;
+    if (budgetUs > 0 && p99Us > budgetUs) {
+        printf("Error: p99 frame time %.2f us is over the %.2f us budget!\n", p99Us, budgetUs);
+        return 1;
+    }
+    return 0;
 }
 
 void InitGame()
@@ -265,93 +496,63 @@ void InitGame()
             grid[i][j] = EMPTY;
         }
     }
+    BoardInit(&gameBoard, classicGeometry);
     gameOver = false;
     winner = EMPTY;
     currentPlayerTurn = PLAYER_X_TURN;
+    gameStartedAt = TimerNowNs();
+
+    // The model stays the same for the whole game. Replays wait for the one the recorded game had.
+    uint32_t modelGames;
+    if (ReplayNextValue(&modelGames)) {
+        aiEngine.model = LearnerTakeAt(modelGames);
+    } else {
+        aiEngine.model = LearnerTake();
+        ReplayRecordValue(aiEngine.model != NULL ? (uint32_t)aiEngine.model->games : 0);
+    }
+    boardVersion++;
 }
 
-// Minimax algorithm
-int Minimax(Cell board[GRID_SIZE][GRID_SIZE], bool isMaximizing, int depth, int depthLimit)
+// Map the endgame tablebase, building it on first launch
+void LoadEndgameTablebase()
 {
-    if (depth >= depthLimit) return 0; // Return 0 if depth limit is reached
+    classicGeometry = BoardGeometryGet(GRID_SIZE, GRID_SIZE);
+    if (TablebaseOpen(&endgameTablebase, TB_DEFAULT_FILE, classicGeometry)) return;
 
-    int score = EvaluateBoard(board);
-    if (score == 10) return score - depth; // O (AI) is the maximizing player
-    if (score == -10) return score + depth; // X (human) is the minimizing player
-    if (CheckDraw()) return 0; // Draw
-
-    if (isMaximizing)
-    {
-        int bestScore = -1000;
-        for (int i = 0; i < GRID_SIZE; i++)
-        {
-            for (int j = 0; j < GRID_SIZE; j++)
-            {
-                if (board[i][j] == EMPTY)
-                {
-                    board[i][j] = PLAYER_O;
-                    bestScore = fmax(bestScore, Minimax(board, false, depth + 1, depthLimit));
-                    board[i][j] = EMPTY;
-                }
-            }
-        }
-        return bestScore;
-    }
-    else
-    {
-        int bestScore = 1000;
-        for (int i = 0; i < GRID_SIZE; i++)
-        {
-            for (int j = 0; j < GRID_SIZE; j++)
-            {
-                if (board[i][j] == EMPTY)
-                {
-                    board[i][j] = PLAYER_X;
-                    bestScore = fmin(bestScore, Minimax(board, true, depth + 1, depthLimit));
-                    board[i][j] = EMPTY;
-                }
-            }
-        }
-        return bestScore;
+    fprintf(stderr, "Building endgame tablebase...\n"); // stdout may be a protocol stream
+    if (TablebaseBuild(TB_DEFAULT_FILE, classicGeometry, ENDGAME_MAX_EMPTY, 4096)) {
+        TablebaseOpen(&endgameTablebase, TB_DEFAULT_FILE, classicGeometry);
     }
 }
 
-int EvaluateBoard(Cell board[GRID_SIZE][GRID_SIZE])
-{
-    // Check rows and columns for a win
-    for (int row = 0; row < GRID_SIZE; row++)
-    {
-        if (board[row][0] == board[row][1] && board[row][0] == board[row][2])
-        {
-            if (board[row][0] == PLAYER_O) return 10;
-            else if (board[row][0] == PLAYER_X) return -10;
-        }
-    }
-    for (int col = 0; col < GRID_SIZE; col++)
-    {
-        if (board[0][col] == board[1][col] && board[0][col] == board[2][col])
-        {
-            if (board[0][col] == PLAYER_O) return 10;
-            else if (board[0][col] == PLAYER_X) return -10;
+// Reads the next labelled row of the dataset, with X = 1 and O = -1 like the
+// positions the learner is fed
+static bool ReadTrainingRow(FILE *file, float features[FEATURES], int *outcome) {
+    const BoardGeometry *geo = BoardGeometryGet(GRID_SIZE, GRID_SIZE);
+    char line[100];
+    while (fgets(line, sizeof(line), file)) {
+        PackedPosition position;
+        if (!BatchParseRow(line, geo, &position, outcome) || *outcome < 0) continue;
+        for (int i = 0; i < FEATURES; i++) {
+            if (position.x & (1ull << i)) features[i] = 1.0;
+            else if (position.o & (1ull << i)) features[i] = -1.0;
+            else features[i] = 0.0;
         }
+        return true;
     }
+    return false;
+}
 
-    // Check diagonals for a win
-    if (board[0][0] == board[1][1] && board[0][0] == board[2][2])
-    {
-        if (board[0][0] == PLAYER_O) return 10;
-        else if (board[0][0] == PLAYER_X) return -10;
-    }
-    if (board[0][2] == board[1][1] && board[0][2] == board[2][0])
-    {
-        if (board[0][2] == PLAYER_O) return 10;
-        else if (board[0][2] == PLAYER_X) return -10;
+// The model's estimate of X winning, before thresholding
+static float LinearRegressionOutput(float weights[FEATURES + 1], float features[FEATURES]) {
+    float result = weights[FEATURES]; // Start with bias
+    for (int i = 0; i < FEATURES; i++) {
+        result += weights[i] * features[i];
     }
-
-    return 0; // No winner
+    return result;
 }
 
-// Linear Regression Training
+// Linear Regression Training, with the same LMS update the learner applies later
 void TrainLinearRegression(float weights[FEATURES + 1], float learningRate, int epochs) {
     FILE *file = fopen("tic-tac-toe.data", "r");
     if (file == NULL) {
@@ -359,22 +560,18 @@ void TrainLinearRegression(float weights[FEATURES + 1], float learningRate, int
         return;
     }
 
-    char line[100];
+    TRACE_BEGIN("TrainLinearRegression");
+    long long rows = 0;
     for (int epoch = 0; epoch < epochs; epoch++) {
+        TRACE_BEGIN("epoch");
         rewind(file); // Reset file pointer to the beginning
-        while (fgets(line, sizeof(line), file)) {
-            float features[FEATURES] = {0};
-            int outcome = (line[9] == '1') ? 1 : 0; // Convert outcome to 0 or 1
-
-            // Convert board state to features
-            for (int i = 0; i < FEATURES; i++) {
-                if (line[i] == 'x') features[i] = 1.0;
-                else if (line[i] == 'o') features[i] = -1.0;
-                else features[i] = 0.0;
-            }
+        float features[FEATURES];
+        int outcome;
+        while (ReadTrainingRow(file, features, &outcome)) {
+            rows++;
 
             // Calculate prediction
-            float prediction = PredictLinearRegression(weights, features);
+            float prediction = LinearRegressionOutput(weights, features);
 
             // Update weights
             for (int i = 0; i < FEATURES; i++) {
@@ -382,18 +579,17 @@ void TrainLinearRegression(float weights[FEATURES + 1], float learningRate, int
             }
             weights[FEATURES] += learningRate * (outcome - prediction); // Update bias
         }
+        TRACE_COUNTER("rows read", rows);
+        TRACE_END("epoch");
     }
 
     fclose(file);
+    TRACE_END("TrainLinearRegression");
 }
 
 // Linear Regression Prediction
 float PredictLinearRegression(float weights[FEATURES + 1], float features[FEATURES]) {
-    float result = weights[FEATURES]; // Start with bias
-    for (int i = 0; i < FEATURES; i++) {
-        result += weights[i] * features[i];
-    }
-    return result > 0.5 ? 1.0 : 0.0; // Threshold at 0.5
+    return LinearRegressionOutput(weights, features) > 0.5 ? 1.0 : 0.0; // Threshold at 0.5
 }
 
 // Evaluate Linear Regression
@@ -404,20 +600,11 @@ void EvaluateLinearRegression(float weights[FEATURES + 1]) {
         return;
     }
 
-    char line[100];
     confusionMatrix.tp = confusionMatrix.tn = confusionMatrix.fp = confusionMatrix.fn = 0;
 
-    while (fgets(line, sizeof(line), file)) {
-        float features[FEATURES] = {0};
-        int outcome = (line[9] == '1') ? 1 : 0; // Convert outcome to 0 or 1
-
-        // Convert board state to features
-        for (int i = 0; i < FEATURES; i++) {
-            if (line[i] == 'x') features[i] = 1.0;
-            else if (line[i] == 'o') features[i] = -1.0;
-            else features[i] = 0.0;
-        }
-
+    float features[FEATURES];
+    int outcome;
+    while (ReadTrainingRow(file, features, &outcome)) {
         // Calculate prediction
         float prediction = PredictLinearRegression(weights, features);
 
@@ -434,90 +621,90 @@ void EvaluateLinearRegression(float weights[FEATURES + 1]) {
 // function to draw difficulty selection screen
 void DrawDifficultySelect() {
     const int titleFontSize = 40;
-    const int buttonFontSize = 20;
     
     // Title
     const char* title = "Select Difficulty";
-    DrawText(title, 
-        SCREEN_WIDTH/2 - MeasureText(title, titleFontSize)/2, 
+    LayoutDrawText(title, 
+        SCREEN_WIDTH/2 - LayoutMeasureText(title, titleFontSize)/2, 
         SCREEN_HEIGHT/3,
         titleFontSize,
         BLACK);
     
-    // Button rectangles
-    Rectangle easyBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    Rectangle mediumBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + BUTTON_HEIGHT + 20,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    Rectangle hardBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-
-    // Add back button at top left
-    Rectangle backBtn = {
-        20,                // Left margin
-        10,                // Top margin  
-        SCREEN_WIDTH/6,    // Width (100px at 600px screen width)
-        30                 // Height
-    };
-
-    Vector2 mousePos = GetMousePosition();
-    
-    // Check hover states
-    bool easyHover = CheckCollisionPointRec(mousePos, easyBtn);
-    bool mediumHover = CheckCollisionPointRec(mousePos, mediumBtn);
-    bool hardHover = CheckCollisionPointRec(mousePos, hardBtn);
-    bool backHover = CheckCollisionPointRec(mousePos, backBtn);
+    // Buttons, with the engine toggle and a back button at top left
+    DrawWidgets(&screenWidgets[DIFFICULTY_SELECT]);
+}
 
-    // Draw buttons with hover effects
-    DrawButton(easyBtn, "Easy", buttonFontSize, easyHover);
-    DrawButton(mediumBtn, "Medium", buttonFontSize, mediumHover);
-    DrawButton(hardBtn, "Hard", buttonFontSize, hardHover);
-    DrawButton(backBtn, "Back", buttonFontSize, backHover);
+// The dataset's positive class means X won the game
+bool simulateGame(const BatchResult *result, int expectedOutcome) {
+    bool prediction = result->winner == PLAYER_X;
+    return prediction == (expectedOutcome == 1);
+}
 
-    // Set cursor based on any button hover
-    SetMouseCursor((easyHover || mediumHover || hardHover || backHover) ? 
-        MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+// Reads every row of the dataset and scores them all in one batch.
+// Returns the number of rows; correct[i] is simulateGame's answer for row i.
+static int ScoreDataset(FILE *file, int **outcomes, bool **correct) {
+    int count = 0, capacity = 1024;
+    PackedPosition *positions = malloc(sizeof(PackedPosition) * capacity);
+    *outcomes = malloc(sizeof(int) * capacity);
+    *correct = NULL;
 
-    // Draw back button with hover effect
-    DrawButton(backBtn, "Back", buttonFontSize, backHover);
+    char line[100];
+    while (positions != NULL && *outcomes != NULL && fgets(line, sizeof(line), file)) {
+        int outcome;
+        if (!BatchParseRow(line, classicGeometry, &positions[count], &outcome)) continue;
+        (*outcomes)[count++] = outcome;
+        if (count == capacity) {
+            PackedPosition *grownPositions = realloc(positions, sizeof(PackedPosition) * capacity * 2);
+            if (grownPositions != NULL) positions = grownPositions;
+            int *grownOutcomes = realloc(*outcomes, sizeof(int) * capacity * 2);
+            if (grownOutcomes != NULL) *outcomes = grownOutcomes;
+            if (grownPositions == NULL || grownOutcomes == NULL) break;     // scores the rows read so far
+            capacity *= 2;
+        }
+    }
 
-    // Update cursor state to include back button hover
-    SetMouseCursor((easyHover || mediumHover || hardHover || backHover) ? 
-        MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+    BatchConfig config = {classicGeometry, &endgameTablebase, 0, NULL, 0};
+    BatchResult *results = malloc(sizeof(BatchResult) * (count + 1));
+    *correct = malloc(sizeof(bool) * (count + 1));
+    if (positions == NULL || *outcomes == NULL || results == NULL || *correct == NULL ||
+        !BatchEvaluate(&config, positions, count, results)) {
+        count = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        (*correct)[i] = simulateGame(&results[i], (*outcomes)[i]);
+    }
 
+    free(positions);
+    free(results);
+    return count;
 }
 
-bool simulateGame(char* gameState, int expectedOutcome) {
-    Cell simulatedGrid[GRID_SIZE][GRID_SIZE];
-    
-    // Convert string to grid state
-    int index = 0;
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
-            char c = gameState[index++];
-            if (c == 'x' || c == 'X') simulatedGrid[i][j] = PLAYER_X;
-            else if (c == 'o' || c == 'O') simulatedGrid[i][j] = PLAYER_O;
-            else simulatedGrid[i][j] = EMPTY;
+// Solves every position of the last game to find the move that decided it
+void AnalyzeLastGame()
+{
+    Board board;
+    BoardInit(&board, classicGeometry);
+    PnsSolve(&positionSolver, &board, SOLVER_ITERATIONS, &openingVerdict);
+    analysisNodes = openingVerdict.nodes;
+    turningPoint = -1;
+
+    PnsVerdict before = openingVerdict.verdict;
+    for (int i = 0; i < gameBoard.ply; i++) {
+        int move = gameBoard.moves[i];
+        BoardMakeMove(&board, move & ~BOARD_MOVE_O, (move & BOARD_MOVE_O) ? PLAYER_O : PLAYER_X);
+
+        PnsResult result;
+        PnsSolve(&positionSolver, &board, SOLVER_ITERATIONS, &result);
+        analysisNodes += result.nodes;
+
+        // Verdicts are for the side to move, so a sound move turns a win into a loss and keeps a draw a draw
+        PnsVerdict expected = before == PNS_WIN ? PNS_LOSS : before == PNS_LOSS ? PNS_WIN : before;
+        if (turningPoint == -1 && before != PNS_UNKNOWN && result.verdict != PNS_UNKNOWN && result.verdict != expected) {
+            turningPoint = i;
         }
+        before = result.verdict;
     }
-    
-    int depthLimit = 3; // Set a depth limit for simulation
-    int prediction = Minimax(simulatedGrid, true, 0, depthLimit);
-    return (prediction > 0) == (expectedOutcome == 1);
+    statsVersion++;
 }
 
 // Split the dataset into training and testing sets and calculate accuracy
@@ -526,14 +713,15 @@ void evaluateAccuracy(FILE *file) {
     ConfusionMatrix testingCM = {0, 0, 0, 0};
     AccuracyResult trainAcc = {0, 0}, testAcc = {0, 0};
     
-    char line[100];
-    int lineCount = 0;
+    int *outcomes;
+    bool *correct;
+    int count = ScoreDataset(file, &outcomes, &correct);
 
-    while (fgets(line, sizeof(line), file)) {
-        int outcome = line[9] - '0'; // Example: Assume outcome is in column 10
+    for (int lineCount = 0; lineCount < count; lineCount++) {
+        int outcome = outcomes[lineCount];
 
         if (lineCount < 800) { // 80% Training
-            if (simulateGame(line, outcome)) {
+            if (correct[lineCount]) {
                 trainAcc.correctPredictions++;
                 if (outcome == 1) trainingCM.tp++; // True Positive
                 else trainingCM.tn++; // True Negative
@@ -543,7 +731,7 @@ void evaluateAccuracy(FILE *file) {
             }
             trainAcc.totalPredictions++;
         } else { // 20% Testing
-            if (simulateGame(line, outcome)) {
+            if (correct[lineCount]) {
                 testAcc.correctPredictions++;
                 if (outcome == 1) testingCM.tp++; // True Positive
                 else testingCM.tn++; // True Negative
@@ -553,8 +741,9 @@ void evaluateAccuracy(FILE *file) {
             }
             testAcc.totalPredictions++;
         }
-        lineCount++;
     }
+    free(outcomes);
+    free(correct);
 
     // Calculate and print training and testing accuracy
     printf("Training Accuracy: %.2f%%\n", (float)trainAcc.correctPredictions / trainAcc.totalPredictions * 100);
@@ -597,20 +786,21 @@ void LoadAndEvaluateDataset() {
     int totalCorrectTest = 0;
     int totalTest = 0;
     
-    char line[100];
-    int lineCount = 0;
-
     // Reset confusion matrix
     confusionMatrix.tp = 0;
     confusionMatrix.tn = 0;
     confusionMatrix.fp = 0;
     confusionMatrix.fn = 0;
 
-    while (fgets(line, sizeof(line), file)) {
-        int outcome = line[9] - '0';
+    int *outcomes;
+    bool *correct;
+    int count = ScoreDataset(file, &outcomes, &correct);
+
+    for (int lineCount = 0; lineCount < count; lineCount++) {
+        int outcome = outcomes[lineCount];
 
         if (lineCount < 800) { // 80% Training
-            if (simulateGame(line, outcome)) {
+            if (correct[lineCount]) {
                 totalCorrectTrain++;
                 if (outcome == 1) confusionMatrix.tp++;
                 else confusionMatrix.tn++;
@@ -620,25 +810,27 @@ void LoadAndEvaluateDataset() {
             }
             totalTrain++;
         } else { // 20% Testing
-            if (simulateGame(line, outcome)) {
+            if (correct[lineCount]) {
                 totalCorrectTest++;
             }
             totalTest++;
         }
-        lineCount++;
     }
+    free(outcomes);
+    free(correct);
 
     trainingAccuracy = (float)totalCorrectTrain / totalTrain * 100;
     testingAccuracy = (float)totalCorrectTest / totalTest * 100;
+    statsVersion++;
 
     fclose(file);
 }
 
 void HandlePlayerTurn()
 {
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+    if (InputClicked())
     {
-        Vector2 mousePos = GetMousePosition();
+        Vector2 mousePos = InputMouse();
         int row = (int)(mousePos.y / CELL_SIZE);
         int col = (int)(mousePos.x / CELL_SIZE);
 
@@ -646,30 +838,26 @@ void HandlePlayerTurn()
         {
             if (grid[row][col] == EMPTY)
             {
-                grid[row][col] = (currentPlayerTurn == PLAYER_X_TURN) ? PLAYER_X : PLAYER_O;
+                PlaceMark(row, col, (currentPlayerTurn == PLAYER_X_TURN) ? PLAYER_X : PLAYER_O);
                 if (CheckWin(grid[row][col]))
                 {
                     gameOver = true;
                     winner = grid[row][col];
                     gameState = GAME_OVER;
+                    SaveGameRecord();
                     
                     // Track AI losses when player wins
                     if (winner == PLAYER_X && !isTwoPlayer) {
-                        switch(currentDifficulty) {
-                            case EASY: easyStats.losses++; easyStats.totalGames++; break;
-                            case MEDIUM: mediumStats.losses++; mediumStats.totalGames++; break;
-                            case HARD: hardStats.losses++; hardStats.totalGames++; break;
-                        }
+                        CountGameResult(STATS_LOSS);
                     }
                 }
                 else if (CheckDraw())
                 {
                     gameOver = true;
                     gameState = GAME_OVER;
-                    switch(currentDifficulty) {
-                        case EASY: easyStats.draws++; easyStats.totalGames++; break;
-                        case MEDIUM: mediumStats.draws++; mediumStats.totalGames++; break;
-                        case HARD: hardStats.draws++; hardStats.totalGames++; break;
+                    SaveGameRecord();
+                    if (!isTwoPlayer) {
+                        CountGameResult(STATS_DRAW);
                     }
                 }
                 else
@@ -681,20 +869,43 @@ void HandlePlayerTurn()
     }
 }
 
+// Adds a finished game to the current difficulty's results, and to the stats kept on disk
+void CountGameResult(StatsResult result)
+{
+    DifficultyStats *stats = &easyStats;
+    switch(currentDifficulty) {
+        case EASY: stats = &easyStats; break;
+        case MEDIUM: stats = &mediumStats; break;
+        case HARD: stats = &hardStats; break;
+    }
+    if (result == STATS_WIN) stats->wins++;
+    else if (result == STATS_LOSS) stats->losses++;
+    else stats->draws++;
+    stats->totalGames++;
+
+    StatsStoreRecord(currentDifficulty, result);
+    statsVersion++;
+}
+
+// Keeps the finished game, in the game log and as positions for the learner
+void SaveGameRecord()
+{
+    LearnerAddGame(&gameBoard);
+
+    int mode = isTwoPlayer ? GAME_TWO_PLAYER : (int)currentDifficulty | (currentEngine == ENGINE_MCTS ? GAME_MCTS : 0);
+    GameRecord record = GameRecordFromBoard(&gameBoard, mode, (uint32_t)((TimerNowNs() - gameStartedAt) / 1000000000ULL), (uint32_t)time(NULL));
+    if (GameDbAppend(&gameLog, &record)) fflush(gameLog.file);
+}
+
 void UpdateGame()
 {
     if (gameOver) return;
 
-    // quit button click
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+    // quit, undo and redo buttons
+    if (InputClicked() && hotWidget != NULL)
     {
-        Vector2 mousePos = GetMousePosition();
-        if (mousePos.x >= SCREEN_WIDTH - 80 && mousePos.x <= SCREEN_WIDTH - 10 &&
-            mousePos.y >= 10 && mousePos.y <= 40)
-        {
-            gameState = MENU;
-            return;
-        }
+        ActivateWidget(hotWidget);
+        return;
     }
 
     // Handle game moves
@@ -710,7 +921,7 @@ void UpdateGame()
         }
         else
         {
-            AITurn();
+            PROFILE_SCOPE(PROFILE_AI) AITurn();
         }
     }
 }
@@ -718,221 +929,155 @@ void UpdateGame()
 void AITurn()
 {
     printf("AI's turn\n"); // Debug print
-    int bestScore = -1000;
-    int bestRow = -1;
-    int bestCol = -1;
-
-    // Easy mode: 40% chance of random move
-    if (currentDifficulty == EASY) {
-        if (GetRandomValue(0, 100) < 40) {
-            // Attempt a random move
-            for (int attempt = 0; attempt < 9; attempt++) { // Try up to 9 times
-                bestRow = GetRandomValue(0, 2);
-                bestCol = GetRandomValue(0, 2);
-                if (grid[bestRow][bestCol] == EMPTY) {
-                    grid[bestRow][bestCol] = PLAYER_O;
-                    break;
-                }
-            }
-        } else {
-            // If random move fails, fall back to a simple strategy
-            for (int i = 0; i < GRID_SIZE; i++) {
-                for (int j = 0; j < GRID_SIZE; j++) {
-                    if (grid[i][j] == EMPTY) {
-                        grid[i][j] = PLAYER_O;
-                        bestRow = i;
-                        bestCol = j;
-                        break;
-                    }
-                }
-                if (bestRow != -1) break;
-            }
-        }
-    }
-    // Medium mode: use Minimax with limited depth
-    else if (currentDifficulty == MEDIUM)
-    {
-        int depthLimit = 3; // Set a depth limit for medium difficulty
-        for (int i = 0; i < GRID_SIZE; i++) {
-            for (int j = 0; j < GRID_SIZE; j++) {
-                if (grid[i][j] == EMPTY) {
-                    grid[i][j] = PLAYER_O;
-                    int score = Minimax(grid, false, 0, depthLimit);
-                    grid[i][j] = EMPTY;
-
-                    if (score > bestScore) {
-                        bestScore = score;
-                        bestRow = i;
-                        bestCol = j;
-                    }
-                }
-            }
-        }
-    }
-    // Hard mode: full Minimax search
-    else if (currentDifficulty == HARD)
-    {
-        int depthLimit = 9; // Full depth for hard mode
-        for (int i = 0; i < GRID_SIZE; i++) {
-            for (int j = 0; j < GRID_SIZE; j++) {
-                if (grid[i][j] == EMPTY) {
-                    grid[i][j] = PLAYER_O;
-                    int score = Minimax(grid, false, 0, depthLimit);
-                    grid[i][j] = EMPTY;
-
-                    if (score > bestScore) {
-                        bestScore = score;
-                        bestRow = i;
-                        bestCol = j;
-                    }
-                }
-            }
-        }
+
+    // Settings can change between games; the engine keeps its MCTS tree either way
+    aiEngine.config = EngineConfigDefault(currentEngine, currentDifficulty);
+
+    int move = EngineChooseMove(&aiEngine, &gameBoard);
+
+    // Marks the moves the threat search found a forced win for on the trace
+    if (move != -1 && aiEngine.lastThreat.win) {
+        TRACE_INSTANT("forced win");
+        TRACE_COUNTER("forced win depth", aiEngine.lastThreat.depth);
     }
 
     // Ensure a move is made
-    if (bestRow != -1 && bestCol != -1) {
-        grid[bestRow][bestCol] = PLAYER_O;
+    if (move != -1) {
+        PlaceMark(move / GRID_SIZE, move % GRID_SIZE, PLAYER_O);
     }
 
     if (CheckWin(PLAYER_O)) {
         gameOver = true;
         winner = PLAYER_O;
         gameState = GAME_OVER;
-        switch(currentDifficulty) {
-            case EASY: easyStats.wins++; easyStats.totalGames++; break;
-            case MEDIUM: mediumStats.wins++; mediumStats.totalGames++; break;
-            case HARD: hardStats.wins++; hardStats.totalGames++; break;
-        }
+        SaveGameRecord();
+        CountGameResult(STATS_WIN);
     } 
     else if (CheckDraw()) {
         gameOver = true;
         gameState = GAME_OVER;
-        switch(currentDifficulty) {
-            case EASY: easyStats.draws++; easyStats.totalGames++; break;
-            case MEDIUM: mediumStats.draws++; mediumStats.totalGames++; break;
-            case HARD: hardStats.draws++; hardStats.totalGames++; break;
-        }
+        SaveGameRecord();
+        CountGameResult(STATS_DRAW);
     } 
     else {
         currentPlayerTurn = PLAYER_X_TURN;
     }
 }
 
-bool CheckWin(Cell player)
+// Keeps grid (used for drawing) and gameBoard (used for rules) in step
+void PlaceMark(int row, int col, Cell player)
 {
-    // check rows and columns
-    for (int i = 0; i < GRID_SIZE; i++)
-    {
-        if (grid[i][0] == player && grid[i][1] == player && grid[i][2] == player) return true; // Row check
-        if (grid[0][i] == player && grid[1][i] == player && grid[2][i] == player) return true; // Column check
+    grid[row][col] = player;
+    BoardMakeMove(&gameBoard, row * GRID_SIZE + col, player);
+    boardVersion++;
+}
+
+// Against the AI a whole move pair is taken back so it is the player's turn again
+void UndoMove()
+{
+    int count = (!isTwoPlayer && BoardPly(&gameBoard) >= 2) ? 2 : 1;
+    for (int i = 0; i < count; i++) {
+        int cell = BoardUnmakeMove(&gameBoard);
+        if (cell == -1) break;
+        grid[cell / GRID_SIZE][cell % GRID_SIZE] = EMPTY;
     }
+    currentPlayerTurn = (BoardSideToMove(&gameBoard) == PLAYER_X) ? PLAYER_X_TURN : PLAYER_O_TURN;
+    boardVersion++;
+}
 
-    // Check diagonals
-    if (grid[0][0] == player && grid[1][1] == player && grid[2][2] == player) return true; // Main diagonal
-    if (grid[0][2] == player && grid[1][1] == player && grid[2][0] == player) return true; // Anti diagonal
+void RedoMove()
+{
+    int count = isTwoPlayer ? 1 : 2;
+    for (int i = 0; i < count; i++) {
+        int cell = BoardRedoMove(&gameBoard);
+        if (cell == -1) break;
+        grid[cell / GRID_SIZE][cell % GRID_SIZE] = BoardGetCell(&gameBoard, cell);
+    }
+    currentPlayerTurn = (BoardSideToMove(&gameBoard) == PLAYER_X) ? PLAYER_X_TURN : PLAYER_O_TURN;
+    boardVersion++;
+}
 
-    return false; // No win found
+bool CheckWin(Cell player)
+{
+    return BoardHasLine(&gameBoard, player); // line counters are updated on every move
 }
 
 bool CheckDraw()
 {
-    for (int i = 0; i < GRID_SIZE; i++)
-    {
-        for (int j = 0; j < GRID_SIZE; j++)
-        {
-            if (grid[i][j] == EMPTY) return false; // If there's an empty cell, it's not a draw
-        }
-    }
-    return true; // All cells are filled
+    return gameBoard.filled == classicGeometry->cellCount; // All cells are filled
 }
 
 void DrawGame()
 {
-    Vector2 mousePos = GetMousePosition();
-    
-    // Quit button hover (keep this part if you want the quit button to work)
-    bool isQuitHovered = (mousePos.x >= SCREEN_WIDTH - 80 && mousePos.x <= SCREEN_WIDTH - 10 &&
-                         mousePos.y >= 10 && mousePos.y <= 40);
-    
-    // Only set cursor for quit button if we're not in game over state
-    if (!gameOver && isQuitHovered) {
-        SetMouseCursor(MOUSE_CURSOR_POINTING_HAND);
-    } else if (!gameOver) {
-        SetMouseCursor(MOUSE_CURSOR_DEFAULT);
-    }
+    // The board, pieces and turn only change with a move, so they are drawn once per move
+    if (LayerBegin(&boardLayer, SCREEN_WIDTH, SCREEN_HEIGHT, boardVersion)) {
+        ClearBackground(RAYWHITE);
 
-    // the grid and pieces
-    for (int i = 0; i < GRID_SIZE; i++)
-    {
-        for (int j = 0; j < GRID_SIZE; j++)
+        // the grid and pieces
+        for (int i = 0; i < GRID_SIZE; i++)
         {
-            Rectangle cell = {(float)(j * CELL_SIZE), (float)(i * CELL_SIZE), (float)CELL_SIZE, (float)CELL_SIZE};
-            DrawRectangleRec(cell, LIGHTGRAY);
-
-            if (grid[i][j] == PLAYER_X)
-            {
-                const char* text = "X";
-                float fontSize = 100;
-                float textWidth = MeasureText(text, fontSize);
-                float textHeight = fontSize * 0.75f; // Approximate height of the text
-                float textX = cell.x + (CELL_SIZE - textWidth) / 2;
-                float textY = cell.y + (CELL_SIZE - textHeight) / 2;
-                DrawText(text, textX, textY, fontSize, BLUE);
-            }
-            else if (grid[i][j] == PLAYER_O)
+            for (int j = 0; j < GRID_SIZE; j++)
             {
-                const char* text = "O";
-                float fontSize = 100;
-                float textWidth = MeasureText(text, fontSize);
-                float textHeight = fontSize * 0.75f; // Approximate height of the text
-                float textX = cell.x + (CELL_SIZE - textWidth) / 2;
-                float textY = cell.y + (CELL_SIZE - textHeight) / 2;
-                DrawText(text, textX, textY, fontSize, RED);
+                Rectangle cell = {(float)(j * CELL_SIZE), (float)(i * CELL_SIZE), (float)CELL_SIZE, (float)CELL_SIZE};
+                DrawRectangleRec(cell, LIGHTGRAY);
+
+                if (grid[i][j] == PLAYER_X)
+                {
+                    const char* text = "X";
+                    float fontSize = 100;
+                    float textWidth = LayoutMeasureText(text, fontSize);
+                    float textHeight = fontSize * 0.75f; // Approximate height of the text
+                    float textX = cell.x + (CELL_SIZE - textWidth) / 2;
+                    float textY = cell.y + (CELL_SIZE - textHeight) / 2;
+                    LayoutDrawText(text, textX, textY, fontSize, BLUE);
+                }
+                else if (grid[i][j] == PLAYER_O)
+                {
+                    const char* text = "O";
+                    float fontSize = 100;
+                    float textWidth = LayoutMeasureText(text, fontSize);
+                    float textHeight = fontSize * 0.75f; // Approximate height of the text
+                    float textX = cell.x + (CELL_SIZE - textWidth) / 2;
+                    float textY = cell.y + (CELL_SIZE - textHeight) / 2;
+                    LayoutDrawText(text, textX, textY, fontSize, RED);
+                }
             }
         }
-    }
 
-    // grid lines
-    for (int i = 1; i < GRID_SIZE; i++)
-    {
-        DrawLine(i * CELL_SIZE, 0, i * CELL_SIZE, SCREEN_HEIGHT, BLACK);
-        DrawLine(0, i * CELL_SIZE, SCREEN_WIDTH, i * CELL_SIZE, BLACK);
-    }
+        // grid lines
+        for (int i = 1; i < GRID_SIZE; i++)
+        {
+            DrawLine(i * CELL_SIZE, 0, i * CELL_SIZE, SCREEN_HEIGHT, BLACK);
+            DrawLine(0, i * CELL_SIZE, SCREEN_WIDTH, i * CELL_SIZE, BLACK);
+        }
 
-    // quit button
-    Rectangle quitBtn = {
-        SCREEN_WIDTH - 80, 10,  // position
-        70, 30                  // size
-    };
-    
-    // Use the existing mousePos variable instead of declaring a new one
-    // Update isQuitHovered using CheckCollisionPointRec
-    isQuitHovered = CheckCollisionPointRec(mousePos, quitBtn);
-    
-    DrawButton(quitBtn, "Quit", 20, !gameOver && isQuitHovered);
-
-    // turn indicator
-    if (!gameOver) {
-        const char* turnText;
-        if (currentPlayerTurn == PLAYER_X_TURN) {
-            turnText = "Player X's Turn";
-            DrawText(turnText, SCREEN_WIDTH/2 - MeasureText(turnText, 30)/2, 20, 30, BLUE);
-        } 
-        else {
-            if (isTwoPlayer) {
-                turnText = "Player O's Turn";
-            } else {
-                turnText = "AI's Turn";
+        // turn indicator
+        if (!gameOver) {
+            const char* turnText;
+            if (currentPlayerTurn == PLAYER_X_TURN) {
+                turnText = "Player X's Turn";
+                LayoutDrawText(turnText, SCREEN_WIDTH/2 - LayoutMeasureText(turnText, 30)/2, 20, 30, BLUE);
+            } 
+            else {
+                if (isTwoPlayer) {
+                    turnText = "Player O's Turn";
+                } else {
+                    turnText = "AI's Turn";
+                }
+                LayoutDrawText(turnText, SCREEN_WIDTH/2 - LayoutMeasureText(turnText, 30)/2, 20, 30, RED);
             }
-            DrawText(turnText, SCREEN_WIDTH/2 - MeasureText(turnText, 30)/2, 20, 30, RED);
         }
+
+        LayerEnd(&boardLayer);
     }
+    LayerDraw(&boardLayer, (Vector2){ 0, 0 });
+
+    // quit, undo and redo buttons, which stay inert once the game is over
+    DrawWidgets(&screenWidgets[GAME]);
 }
 
 void DrawMenu() {
     const int titleFontSize = 40;
-    const int buttonFontSize = 20;
     
     // Title
     const char* title = "Tic-Tac-Toe";
@@ -942,6 +1087,38 @@ void DrawMenu() {
     const int startX = SCREEN_WIDTH/2 - gridWidth/2;
     const int startY = SCREEN_HEIGHT/5;
 
+    // The title grid fades symbols in and out for as long as the menu is up
+    FrameRequestAnimation(&framePacer);
+
+    // The grid lines and title are drawn once; only the symbols animate
+    if (LayerBegin(&menuLayer, SCREEN_WIDTH, SCREEN_HEIGHT, 0)) {
+        ClearBackground(RAYWHITE);
+
+        for(int i = 0; i < TITLE_GRID_SIZE; i++) {
+            for(int j = 0; j < TITLE_GRID_SIZE; j++) {
+                Rectangle cell = {
+                    startX + j * cellSize,
+                    startY + i * cellSize,
+                    cellSize,
+                    cellSize
+                };
+
+                // Draw just the grid lines
+                DrawRectangleLinesEx(cell, 2, BLACK);
+            }
+        }
+
+        // Draw title text below the grid
+        LayoutDrawText(title, 
+            SCREEN_WIDTH/2 - LayoutMeasureText(title, titleFontSize)/2,
+            startY + gridHeight + 20,
+            titleFontSize,
+            BLACK);
+
+        LayerEnd(&menuLayer);
+    }
+    LayerDraw(&menuLayer, (Vector2){ 0, 0 });
+
     // cell animations
     for(int i = 0; i < TITLE_GRID_SIZE; i++) {
         for(int j = 0; j < TITLE_GRID_SIZE; j++) {
@@ -951,9 +1128,6 @@ void DrawMenu() {
                 cellSize,
                 cellSize
             };
-            
-            // Draw just the grid lines
-            DrawRectangleLinesEx(cell, 2, BLACK);
 
             // Handle the X and O symbols
             if (!titleSymbols[i][j].active && GetRandomValue(0, 100) < 2) {
@@ -972,73 +1146,22 @@ void DrawMenu() {
                 Color symbolColor = titleSymbols[i][j].symbol == 'X' ? BLUE : RED;
                 symbolColor.a = (unsigned char)(titleSymbols[i][j].alpha * 255);
                 
+                const char *symbolText = titleSymbols[i][j].symbol == 'X' ? "X" : "O";
                 Vector2 textPos = {
-                    cell.x + (cellSize - MeasureText(&titleSymbols[i][j].symbol, 40))/2,
+                    cell.x + (cellSize - LayoutMeasureText(symbolText, 40))/2,
                     cell.y + (cellSize - 40)/2
                 };
-                DrawText(&titleSymbols[i][j].symbol, textPos.x, textPos.y, 40, symbolColor);
+                LayoutDrawText(symbolText, textPos.x, textPos.y, 40, symbolColor);
             }
         }
     }
 
-    // Draw title text below the grid
-    DrawText(title, 
-        SCREEN_WIDTH/2 - MeasureText(title, titleFontSize)/2,
-        startY + gridHeight + 20,
-        titleFontSize,
-        BLACK);
-    
-    // Button rectangles
-    Rectangle singlePlayerBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + BUTTON_HEIGHT + 20,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    Rectangle twoPlayerBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 2,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    Rectangle analysisBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 3,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-
-    Rectangle howToPlayBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + (BUTTON_HEIGHT + 20) * 4,  // Position below analysis button
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    Vector2 mousePos = GetMousePosition();
-
-    // Check hover states
-    bool singlePlayerHover = CheckCollisionPointRec(mousePos, singlePlayerBtn);
-    bool twoPlayerHover = CheckCollisionPointRec(mousePos, twoPlayerBtn);
-    bool analysisHover = CheckCollisionPointRec(mousePos, analysisBtn);
-    bool howToPlayHover = CheckCollisionPointRec(mousePos, howToPlayBtn);
-
     // Draw buttons with hover effects
-    DrawButton(singlePlayerBtn, "Single Player", buttonFontSize, singlePlayerHover);
-    DrawButton(twoPlayerBtn, "Two Players", buttonFontSize, twoPlayerHover);
-    DrawButton(analysisBtn, "View AI Analysis", buttonFontSize, analysisHover);
-    DrawButton(howToPlayBtn, "How to Play", buttonFontSize, howToPlayHover);
-
-    // Set cursor based on any button hover
-    SetMouseCursor((singlePlayerHover || twoPlayerHover || analysisHover || howToPlayHover) ? 
-        MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+    DrawWidgets(&screenWidgets[MENU]);
 }
 
 void DrawGameOver() {
     const int titleFontSize = 40;
-    const int buttonFontSize = 20;
     
     // Draw semi-transparent overlay
     DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color){0, 0, 0, 100});
@@ -1059,7 +1182,7 @@ void DrawGameOver() {
     }
     
     // Draw result text with background
-    int textWidth = MeasureText(resultText, titleFontSize);
+    int textWidth = LayoutMeasureText(resultText, titleFontSize);
     DrawRectangle(
         SCREEN_WIDTH/2 - textWidth/2 - 10,
         SCREEN_HEIGHT/3 - 10,
@@ -1067,39 +1190,15 @@ void DrawGameOver() {
         titleFontSize + 20,
         WHITE
     );
-    DrawText(resultText, 
+    LayoutDrawText(resultText, 
         SCREEN_WIDTH/2 - textWidth/2,
         SCREEN_HEIGHT/3,
         titleFontSize,
         resultColor
     );
     
-    // Retry Button
-    Rectangle retryBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + 40, // Position above the menu button
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-    
-    // Back to Menu Button
-    Rectangle menuBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT/2 + 100,  // Position below the retry button
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-          
-    Vector2 mousePos = GetMousePosition();
-    bool isHoveringMenu = CheckCollisionPointRec(mousePos, menuBtn);
-    bool isHoveringRetry = CheckCollisionPointRec(mousePos, retryBtn);
-    
-    // Draw buttons with hover effect
-    DrawButton(retryBtn, "Retry", buttonFontSize, isHoveringRetry);
-    DrawButton(menuBtn, "Back to Menu", buttonFontSize, isHoveringMenu);
-    
-    // Set cursor
-    SetMouseCursor((isHoveringMenu || isHoveringRetry) ? MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+    // Retry and Back to Menu buttons
+    DrawWidgets(&screenWidgets[GAME_OVER]);
 }
 
 void DrawAIAnalysis() {
@@ -1108,78 +1207,106 @@ void DrawAIAnalysis() {
     const int padding = 20;
     
     // Handle scrolling with mouse wheel
-    scrollY += GetMouseWheelMove() * scrollSpeed;
+    scrollY += InputWheel() * scrollSpeed;
     
     // Calculate total content height
-    float totalContentHeight = 900;  // Total height of all content
+    float totalContentHeight = ANALYSIS_CONTENT_HEIGHT;  // Total height of all content
     float visibleHeight = SCREEN_HEIGHT - (BUTTON_HEIGHT + padding);  // Visible area height
     
     // Limit scrolling
     float maxScroll = totalContentHeight - visibleHeight;
     if (scrollY > 0) scrollY = 0;
     if (scrollY < -maxScroll && maxScroll > 0) scrollY = -maxScroll;
-    
-    // Apply scroll offset to starting Y position
-    int currentY = 40 + scrollY;
-    
-    BeginScissorMode(0, 0, SCREEN_WIDTH - 15, SCREEN_HEIGHT - (BUTTON_HEIGHT + padding));  // Leave space for scrollbar
-    
-    // Title
-    const char* title = "AI Performance Analysis";
-    DrawText(title, 
-        SCREEN_WIDTH/2 - MeasureText(title, titleFontSize)/2,
-        currentY,
-        titleFontSize,
-        BLACK);
-    currentY += titleFontSize + padding;
 
-    // Draw Dataset Statistics
-    char buffer[100];
-    snprintf(buffer, sizeof(buffer), "Total Games Played: %d", easyStats.totalGames + mediumStats.totalGames + hardStats.totalGames);
-    DrawText(buffer, padding, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding;
+    // The whole page is drawn once per change to the numbers; scrolling
+    // just shows a different part of it
+    if (LayerBegin(&analysisLayer, SCREEN_WIDTH - 15, ANALYSIS_CONTENT_HEIGHT, statsVersion)) {  // Leave space for scrollbar
+        ClearBackground(RAYWHITE);
+        int currentY = 40;
+
+        // Title
+        const char* title = "AI Performance Analysis";
+        LayoutDrawText(title, 
+            SCREEN_WIDTH/2 - LayoutMeasureText(title, titleFontSize)/2,
+            currentY,
+            titleFontSize,
+            BLACK);
+        currentY += titleFontSize + padding;
+
+        // Draw Dataset Statistics
+        char buffer[100];
+        snprintf(buffer, sizeof(buffer), "Total Games Played: %d", easyStats.totalGames + mediumStats.totalGames + hardStats.totalGames);
+        LayoutDrawText(buffer, padding, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding;
+
+        // Draw Training and Testing Results
+        LayoutDrawText("Model Performance:", padding, currentY, textFontSize + 4, DARKBLUE);
+        currentY += textFontSize + padding/2;
 
-    // Draw Training and Testing Results
-    DrawText("Model Performance:", padding, currentY, textFontSize + 4, DARKBLUE);
-    currentY += textFontSize + padding/2;
+        snprintf(buffer, sizeof(buffer), "Training Accuracy: %.2f%%", trainingAccuracy);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
 
-    snprintf(buffer, sizeof(buffer), "Training Accuracy: %.2f%%", trainingAccuracy);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding/2;
+        snprintf(buffer, sizeof(buffer), "Testing Accuracy: %.2f%%", testingAccuracy);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding;
 
-    snprintf(buffer, sizeof(buffer), "Testing Accuracy: %.2f%%", testingAccuracy);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding;
+        // Draw Confusion Matrix
+        LayoutDrawText("Confusion Matrix:", padding, currentY, textFontSize + 4, DARKBLUE);
+        currentY += textFontSize + padding/2;
 
-    // Draw Confusion Matrix
-    DrawText("Confusion Matrix:", padding, currentY, textFontSize + 4, DARKBLUE);
-    currentY += textFontSize + padding/2;
+        snprintf(buffer, sizeof(buffer), "True Positives: %d", confusionMatrix.tp);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
 
-    snprintf(buffer, sizeof(buffer), "True Positives: %d", confusionMatrix.tp);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding/2;
+        snprintf(buffer, sizeof(buffer), "True Negatives: %d", confusionMatrix.tn);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
 
-    snprintf(buffer, sizeof(buffer), "True Negatives: %d", confusionMatrix.tn);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding/2;
+        snprintf(buffer, sizeof(buffer), "False Positives: %d", confusionMatrix.fp);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
+
+        snprintf(buffer, sizeof(buffer), "False Negatives: %d", confusionMatrix.fn);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding;
 
-    snprintf(buffer, sizeof(buffer), "False Positives: %d", confusionMatrix.fp);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding/2;
+        // Draw Solver Verdicts
+        LayoutDrawText("Solver Verdicts:", padding, currentY, textFontSize + 4, DARKBLUE);
+        currentY += textFontSize + padding/2;
+
+        char proofText[16], disproofText[16];
+        snprintf(proofText, sizeof(proofText), openingVerdict.proof >= PNS_INFINITY ? "inf" : "%u", openingVerdict.proof);
+        snprintf(disproofText, sizeof(disproofText), openingVerdict.disproof >= PNS_INFINITY ? "inf" : "%u", openingVerdict.disproof);
+        snprintf(buffer, sizeof(buffer), "Empty Board: %s (pn %s, dn %s)", PnsVerdictName(openingVerdict.verdict), proofText, disproofText);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
+
+        if (gameBoard.ply == 0) {
+            snprintf(buffer, sizeof(buffer), "Last Game: no moves played yet");
+        } else if (turningPoint == -1) {
+            snprintf(buffer, sizeof(buffer), "Last Game: no move changed the result");
+        } else {
+            snprintf(buffer, sizeof(buffer), "Last Game: decided by %s's move %d", (gameBoard.moves[turningPoint] & BOARD_MOVE_O) ? "O" : "X", turningPoint + 1);
+        }
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding/2;
 
-    snprintf(buffer, sizeof(buffer), "False Negatives: %d", confusionMatrix.fn);
-    DrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
-    currentY += textFontSize + padding;
+        snprintf(buffer, sizeof(buffer), "Solver Nodes: %lld", analysisNodes);
+        LayoutDrawText(buffer, padding * 2, currentY, textFontSize, BLACK);
+        currentY += textFontSize + padding;
 
-    // Draw Difficulty Statistics
-    DrawText("Performance by Difficulty:", padding, currentY, textFontSize + 4, DARKBLUE);
-    currentY += textFontSize + padding;
+        // Draw Difficulty Statistics
+        LayoutDrawText("Performance by Difficulty:", padding, currentY, textFontSize + 4, DARKBLUE);
+        currentY += textFontSize + padding;
 
-    DrawDifficultySection("Easy Mode", easyStats, &currentY, GREEN, padding, textFontSize);
-    DrawDifficultySection("Medium Mode", mediumStats, &currentY, ORANGE, padding, textFontSize);
-    DrawDifficultySection("Hard Mode", hardStats, &currentY, RED, padding, textFontSize);
+        DrawDifficultySection("Easy Mode", easyStats, &currentY, GREEN, padding, textFontSize);
+        DrawDifficultySection("Medium Mode", mediumStats, &currentY, ORANGE, padding, textFontSize);
+        DrawDifficultySection("Hard Mode", hardStats, &currentY, RED, padding, textFontSize);
 
-    EndScissorMode();
+        LayerEnd(&analysisLayer);
+    }
+    LayerDrawRegion(&analysisLayer, (Rectangle){ 0, -scrollY, SCREEN_WIDTH - 15, visibleHeight }, (Vector2){ 0, 0 });
 
     // Draw scrollbar
     if (maxScroll > 0) {
@@ -1199,66 +1326,120 @@ void DrawAIAnalysis() {
         );
     }
 
-    // Back button (outside scissor mode to always be visible)
-    Rectangle backBtn = {
-        SCREEN_WIDTH/2 - BUTTON_WIDTH/2,
-        SCREEN_HEIGHT - BUTTON_HEIGHT - padding/2,
-        BUTTON_WIDTH,
-        BUTTON_HEIGHT
-    };
-
-    Vector2 mousePos = GetMousePosition();
-    bool isHovering = CheckCollisionPointRec(mousePos, backBtn);
-
-    DrawButton(backBtn, "Back to Menu", textFontSize, isHovering);
-
-    SetMouseCursor(isHovering ? MOUSE_CURSOR_POINTING_HAND : MOUSE_CURSOR_DEFAULT);
+    // Back button (outside the page so it is always visible)
+    DrawWidgets(&screenWidgets[AI_ANALYSIS]);
 }
 
 void DrawDifficultySection(const char* difficulty, DifficultyStats stats, int* y, Color color, int padding, int textFontSize) {
     char buffer[100];
     
     // Draw difficulty title
-    DrawText(difficulty, padding, *y, textFontSize + 4, color);
+    LayoutDrawText(difficulty, padding, *y, textFontSize + 4, color);
     *y += textFontSize + padding/2;
 
     // Draw stats
     snprintf(buffer, sizeof(buffer), "Wins: %d", stats.wins);
-    DrawText(buffer, padding * 2, *y, textFontSize, BLACK);
+    LayoutDrawText(buffer, padding * 2, *y, textFontSize, BLACK);
     *y += textFontSize + padding/3;
 
     snprintf(buffer, sizeof(buffer), "Losses: %d", stats.losses);
-    DrawText(buffer, padding * 2, *y, textFontSize, BLACK);
+    LayoutDrawText(buffer, padding * 2, *y, textFontSize, BLACK);
     *y += textFontSize + padding/3;
 
     snprintf(buffer, sizeof(buffer), "Draws: %d", stats.draws);
-    DrawText(buffer, padding * 2, *y, textFontSize, BLACK);
+    LayoutDrawText(buffer, padding * 2, *y, textFontSize, BLACK);
     *y += textFontSize + padding/3;
 
     float winRate = stats.totalGames > 0 ? 
         (float)stats.wins/stats.totalGames * 100 : 0;
     snprintf(buffer, sizeof(buffer), "Win Rate: %.1f%%", winRate);
-    DrawText(buffer, padding * 2, *y, textFontSize, BLACK);
+    LayoutDrawText(buffer, padding * 2, *y, textFontSize, BLACK);
     *y += textFontSize + padding;
 }
 
+// Frame timings of the last PROFILER_OVERLAY_FRAMES frames: a histogram of
+// the work per frame and the average time of each section
+void DrawProfilerOverlay() {
+    static FrameSample samples[PROFILER_OVERLAY_FRAMES];
+    int count = ProfilerSnapshot(samples, PROFILER_OVERLAY_FRAMES);
+    if (count == 0) return;
+
+    const int x = 10, y = SCREEN_HEIGHT - 190, width = 300, height = 180;
+    int histogram[20] = {0};  // 0.5 ms each, the last one catches everything slower
+    const int buckets = sizeof(histogram) / sizeof(histogram[0]);
+    double sections[PROFILE_SECTIONS] = {0};
+    double interval = 0, worst = 0, draws = 0, lastSearch = 0;
+    int paced = 0;
+
+    for (int i = 0; i < count; i++) {
+        double work = 0;
+        for (int s = 0; s < PROFILE_SECTIONS; s++) {
+            work += samples[i].sectionNs[s] / 1e6;
+            sections[s] += samples[i].sectionNs[s] / 1e6;
+        }
+        int bucket = (int)(work * 2);
+        histogram[bucket < buckets ? bucket : buckets - 1]++;
+        if (work > worst) worst = work;
+        if (!samples[i].waited) {
+            interval += samples[i].intervalNs / 1e6;
+            paced++;
+        }
+        if (samples[i].sectionNs[PROFILE_AI] > 0) lastSearch = samples[i].sectionNs[PROFILE_AI] / 1e6;
+        draws += samples[i].drawCalls;
+    }
+
+    DrawRectangle(x, y, width, height, (Color){0, 0, 0, 180});
+
+    int peak = 1;
+    for (int b = 0; b < buckets; b++) if (histogram[b] > peak) peak = histogram[b];
+    for (int b = 0; b < buckets; b++) {
+        int barHeight = histogram[b] * 60 / peak;
+        DrawRectangle(x + 10 + b * 14, y + 70 - barHeight, 12, barHeight, b < 8 ? GREEN : b < 16 ? ORANGE : RED);
+    }
+
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), "Work per frame, 0-10 ms  (worst %.2f ms)", worst);
+    LayoutDrawText(buffer, x + 10, y + 76, 10, WHITE);
+    snprintf(buffer, sizeof(buffer), "Frame interval %.2f ms over %d frames", paced > 0 ? interval / paced : 0.0, count);
+    LayoutDrawText(buffer, x + 10, y + 92, 10, WHITE);
+    for (int s = 0; s < PROFILE_SECTIONS; s++) {
+        snprintf(buffer, sizeof(buffer), "%-8s %.3f ms", ProfileSectionName(s), sections[s] / count);
+        LayoutDrawText(buffer, x + 10 + (s % 2) * 140, y + 108 + (s / 2) * 16, 10, WHITE);
+    }
+    snprintf(buffer, sizeof(buffer), "Last AI search %.2f ms", lastSearch);
+    LayoutDrawText(buffer, x + 10, y + 142, 10, WHITE);
+    snprintf(buffer, sizeof(buffer), "Draw calls %.0f per frame", draws / count);
+    LayoutDrawText(buffer, x + 10, y + 158, 10, WHITE);
+}
+
+void DrawWidgets(const WidgetTable *table) {
+    for (int i = 0; i < table->count; i++) {
+        DrawButton(&table->widgets[i], &table->widgets[i] == hotWidget);
+    }
+}
+
+const char *WidgetLabel(const Widget *widget) {
+    if (widget->id == WIDGET_ENGINE) {
+        return currentEngine == ENGINE_MCTS ? "Engine: MCTS" : "Engine: Minimax";
+    }
+    return widget->label;
+}
+
 // Add the function definition
-void DrawButton(Rectangle bounds, const char* text, int fontSize, bool isHovered) {
-    Rectangle vibrationBounds = bounds;
+void DrawButton(const Widget *widget, bool isHovered) {
+    Rectangle vibrationBounds = widget->bounds;
+    const char *text = WidgetLabel(widget);
+    int fontSize = widget->fontSize;
     
-    if (isHovered && (strstr(text, "Single Player") || 
-                      strstr(text, "Two Players") || 
-                      strstr(text, "Easy") ||
-                      strstr(text, "Medium") ||
-                      strstr(text, "Hard") ||
-                      strstr(text, "View AI Analysis") ||
-                      strstr(text, "How to Play"))) {
+    if (isHovered && (widget->flags & WIDGET_VIBRATES)) {
         buttonVibrationOffset = sinf(GetTime() * vibrationSpeed) * vibrationAmount;
         vibrationBounds.x += buttonVibrationOffset;
+        FrameRequestAnimation(&framePacer);
     }
 
     DrawRectangleRec(vibrationBounds, isHovered ? GRAY : LIGHTGRAY);
     DrawRectangleLinesEx(vibrationBounds, 2, BLACK);
+    ProfilerCountDraws(2);
 
     // individual customization for single player and two players buttons
     // if (strstr(text, "Single Player")) {
@@ -1280,8 +1461,8 @@ void DrawButton(Rectangle bounds, const char* text, int fontSize, bool isHovered
     // else {
     
     // Original button drawing for other buttons
-    DrawText(text,
-        vibrationBounds.x + (vibrationBounds.width - MeasureText(text, fontSize))/2,
+    LayoutDrawText(text,
+        vibrationBounds.x + (vibrationBounds.width - LayoutMeasureText(text, fontSize))/2,
         vibrationBounds.y + (vibrationBounds.height - fontSize)/2,
         fontSize,
         BLACK
@@ -1289,5 +1470,5 @@ void DrawButton(Rectangle bounds, const char* text, int fontSize, bool isHovered
     // }
 }
 
-// gcc -o actualmain actualmain.c -LC:\\msys64\\mingw64\\lib -lraylib
+// gcc -o actualmain actualmain.c board.c tablebase.c mapped_file.c mcts.c engine.c arena.c latency.c platform.c search.c threats.c pns.c book.c eval.c batch.c protocol.c server.c scheduler.c frame.c layer.c text_layout.c widget.c profiler.c trace.c replay.c stats_store.c game_db.c learner.c -LC:\\msys64\\mingw64\\lib -lraylib
 // ./actualmain.exe
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "arena.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ARENA_BATCH 64 // smallest run of games handed to one worker
+
+// Engines and results per scheduler worker, so games never share either
+typedef struct {
+    Engine engines[2];
+    ArenaResult result;
+} ArenaWorker;
+
+typedef struct {
+    const ArenaConfig *config;
+    Scheduler *scheduler;
+    ArenaWorker *workers;
+} ArenaRunState;
+
+static void RecordResult(DifficultyStats *stats, int outcome)
+{
+    if (outcome > 0) stats->wins++;
+    else if (outcome < 0) stats->losses++;
+    else stats->draws++;
+    stats->totalGames++;
+}
+
+// Plays one game and returns the winning engine index, or -1 for a draw
+static int PlayGame(Engine engines[2], int xEngine, const BoardGeometry *geo, ArenaResult *result)
+{
+    Board board;
+    BoardInit(&board, geo);
+    Cell player = PLAYER_X;
+
+    while (board.filled < geo->cellCount) {
+        int current = (player == PLAYER_X) ? xEngine : 1 - xEngine;
+
+        uint64_t start = TimerNowNs();
+        int move = EngineChooseMove(&engines[current], &board);
+        LatencyRecord(&result->moveLatency[current], TimerNowNs() - start);
+        result->moves++;
+
+        if (move < 0) break;
+        BoardMakeMove(&board, move, player);
+        if (BoardCompletesLine(&board, move, player)) return current;
+        player = Opponent(player);
+    }
+    return -1;
+}
+
+static void PlayGames(void *context, long long first, long long last)
+{
+    ArenaRunState *state = context;
+    const ArenaConfig *config = state->config;
+    ArenaWorker *worker = &state->workers[SchedulerWorkerIndex(state->scheduler)];
+
+    for (long long game = first; game < last; game++) {
+        int xEngine = (config->alternateColours && (game & 1)) ? 1 : 0;
+        int winner = PlayGame(worker->engines, xEngine, config->geo, &worker->result);
+        RecordResult(&worker->result.stats[0], winner == -1 ? 0 : (winner == 0 ? 1 : -1));
+        RecordResult(&worker->result.stats[1], winner == -1 ? 0 : (winner == 1 ? 1 : -1));
+    }
+}
+
+static void MergeStats(DifficultyStats *into, const DifficultyStats *from)
+{
+    into->wins += from->wins;
+    into->losses += from->losses;
+    into->draws += from->draws;
+    into->totalGames += from->totalGames;
+}
+
+bool ArenaRun(const ArenaConfig *config, ArenaResult *result)
+{
+    Scheduler *scheduler = config->scheduler != NULL ? config->scheduler : SchedulerShared();
+    if (scheduler == NULL) return false;
+    int threads = SchedulerThreadCount(scheduler);
+    ArenaWorker *workers = calloc((size_t)threads, sizeof(ArenaWorker));
+    if (workers == NULL) return false;
+
+    for (int w = 0; w < threads; w++) {
+        for (int i = 0; i < 2; i++) {
+            EngineInit(&workers[w].engines[i], &config->engines[i], config->tablebase,
+                       config->seed + (uint64_t)w * 2 + (uint64_t)i);
+        }
+    }
+
+    memset(result, 0, sizeof(*result));
+    uint64_t start = TimerNowNs();
+    ArenaRunState state = {config, scheduler, workers};
+    SchedulerParallelFor(scheduler, config->games, ARENA_BATCH, PlayGames, &state);
+    result->seconds = (double)(TimerNowNs() - start) / 1e9;
+
+    for (int w = 0; w < threads; w++) {
+        for (int e = 0; e < 2; e++) {
+            MergeStats(&result->stats[e], &workers[w].result.stats[e]);
+            LatencyMerge(&result->moveLatency[e], &workers[w].result.moveLatency[e]);
+            EngineFree(&workers[w].engines[e]);
+        }
+        result->moves += workers[w].result.moves;
+    }
+    result->gamesPerSecond = result->seconds > 0 ? result->stats[0].totalGames / result->seconds : 0;
+
+    free(workers);
+    return true;
+}
+
+void ArenaPrintReport(const ArenaConfig *config, const ArenaResult *result)
+{
+    char name[64];
+    printf("\nArena: %d games in %.2fs (%.0f games/sec, %lld moves)\n",
+           result->stats[0].totalGames, result->seconds, result->gamesPerSecond, result->moves);
+
+    for (int i = 0; i < 2; i++) {
+        const DifficultyStats *stats = &result->stats[i];
+        const LatencyHistogram *latency = &result->moveLatency[i];
+        printf("%s\n", EngineConfigName(&config->engines[i], name, sizeof(name)));
+        printf("  Wins: %d, Losses: %d, Draws: %d\n", stats->wins, stats->losses, stats->draws);
+        printf("  Move latency (us): mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n",
+               latency->count ? latency->totalNs / 1000.0 / latency->count : 0.0,
+               LatencyPercentile(latency, 50) / 1000.0, LatencyPercentile(latency, 90) / 1000.0,
+               LatencyPercentile(latency, 99) / 1000.0, latency->maxNs / 1000.0);
+    }
+}
+
+int ArenaMain(int argc, char **argv, const BoardGeometry *geo, const Tablebase *tablebase)
+{
+    ArenaConfig config;
+    memset(&config, 0, sizeof(config));
+    config.geo = geo;
+    config.tablebase = tablebase;
+    config.alternateColours = true;
+    config.seed = (uint64_t)TimerNowNs();
+
+    if (argc < 3 || (config.games = atoll(argv[0])) <= 0 ||
+        !EngineConfigParse(argv[1], &config.engines[0]) || !EngineConfigParse(argv[2], &config.engines[1])) {
+        printf("Usage: [--threads N[:pin]] --arena <games> <engineA> <engineB>\n");
+        printf("  engine: [minimax|mcts]:[easy|medium|hard][:depth=N][:random=N][:playouts=N][:tablebase=0|1][:book=0|1][:negamax=0|1][:eval=0|1][:threats=N][:budget=N]\n");
+        return 1;
+    }
+
+    ArenaResult result;
+    if (!ArenaRun(&config, &result)) {
+        printf("Error starting the arena!\n");
+        return 1;
+    }
+    ArenaPrintReport(&config, &result);
+    return 0;
+}
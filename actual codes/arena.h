@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "engine.h"
+#include "latency.h"
+#include "scheduler.h"
+
+// Headless engine-vs-engine matches, spread over the scheduler's workers
+
+typedef struct {
+    EngineConfig engines[2];
+    const BoardGeometry *geo;
+    const Tablebase *tablebase;
+    long long games;
+    Scheduler *scheduler;   // NULL = the shared one
+    bool alternateColours;  // swap who plays X every game
+    uint64_t seed;
+} ArenaConfig;
+
+typedef struct {
+    DifficultyStats stats[2];             // results from each engine's point of view
+    LatencyHistogram moveLatency[2];
+    long long moves;
+    double seconds;
+    double gamesPerSecond;
+} ArenaResult;
+
+bool ArenaRun(const ArenaConfig *config, ArenaResult *result);
+void ArenaPrintReport(const ArenaConfig *config, const ArenaResult *result);
+
+// Entry point for "--arena <games> <engineA> <engineB>"
+int ArenaMain(int argc, char **argv, const BoardGeometry *geo, const Tablebase *tablebase);
+
+#endif // ARENA_H
@@ -0,0 +1,271 @@
+#include "batch.h"
+#include "platform.h"
+#include "search.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    PackedPosition position;
+    size_t index;           // where the position and its result sit in the caller's arrays
+} BatchEntry;
+
+typedef struct {
+    const BatchConfig *config;
+    Scheduler *scheduler;
+    const BatchEntry *entries;
+    BatchResult *results;
+    Search **searches;      // one per worker, created by its first run
+    atomic_bool failed;
+} BatchRunState;
+
+PackedPosition BatchPack(const Board *board)
+{
+    PackedPosition position = {0, 0};
+    for (int cell = 0; cell < board->geo->cellCount && cell < BATCH_MAX_CELLS; cell++) {
+        Cell value = BoardGetCell(board, cell);
+        if (value == PLAYER_X) position.x |= 1ull << cell;
+        else if (value == PLAYER_O) position.o |= 1ull << cell;
+    }
+    return position;
+}
+
+bool BatchUnpack(const PackedPosition *position, const BoardGeometry *geo, Board *board)
+{
+    if (geo->cellCount > BATCH_MAX_CELLS || (position->x & position->o) != 0) return false;
+    uint64_t cells = geo->cellCount == 64 ? ~0ull : (1ull << geo->cellCount) - 1;
+    if (((position->x | position->o) & ~cells) != 0) return false;
+
+    // X moves first, so it has as many pieces as O or one more
+    int xCount = __builtin_popcountll(position->x);
+    int oCount = __builtin_popcountll(position->o);
+    if (xCount != oCount && xCount != oCount + 1) return false;
+
+    BoardInit(board, geo);
+    for (int cell = 0; cell < geo->cellCount; cell++) {
+        if (position->x & (1ull << cell)) BoardSetCell(board, cell, PLAYER_X);
+        else if (position->o & (1ull << cell)) BoardSetCell(board, cell, PLAYER_O);
+    }
+    return true;
+}
+
+bool BatchParseRow(const char *line, const BoardGeometry *geo, PackedPosition *position, int *label)
+{
+    position->x = 0;
+    position->o = 0;
+    *label = -1;
+    if (geo->cellCount > BATCH_MAX_CELLS) return false;
+
+    const char *p = line;
+    for (int cell = 0; cell < geo->cellCount; cell++) {
+        while (*p == ' ') p++;
+        char c = (char)tolower((unsigned char)*p);
+        if (c == 'x') position->x |= 1ull << cell;
+        else if (c == 'o') position->o |= 1ull << cell;
+        else if (c != 'b') return false;
+        p++;
+        while (*p == ' ') p++;
+        if (*p == ',') p++;
+        else if (cell < geo->cellCount - 1) return false;
+    }
+
+    while (*p == ' ') p++;
+    if (strncmp(p, "positive", 8) == 0) *label = 1;
+    else if (strncmp(p, "negative", 8) == 0) *label = 0;
+    return true;
+}
+
+// Fuller boards first, then by the masks themselves so equal positions end up side by side
+static int CompareEntries(const void *a, const void *b)
+{
+    const PackedPosition *pa = &((const BatchEntry *)a)->position;
+    const PackedPosition *pb = &((const BatchEntry *)b)->position;
+    int filledA = __builtin_popcountll(pa->x | pa->o);
+    int filledB = __builtin_popcountll(pb->x | pb->o);
+    if (filledA != filledB) return filledB - filledA;
+    if (pa->x != pb->x) return pa->x < pb->x ? -1 : 1;
+    if (pa->o != pb->o) return pa->o < pb->o ? -1 : 1;
+    return 0;
+}
+
+static bool SamePosition(const PackedPosition *a, const PackedPosition *b)
+{
+    return a->x == b->x && a->o == b->o;
+}
+
+static bool TablebaseCovers(const Tablebase *tb, const BoardGeometry *geo)
+{
+    return tb != NULL && tb->header != NULL && tb->header->size == (uint32_t)geo->size &&
+           tb->header->winLength == (uint32_t)geo->winLength;
+}
+
+static void SetResult(BatchResult *result, Cell mover, int score, int move)
+{
+    result->score = (short)score;
+    result->move = (short)move;
+    result->winner = SearchIsWin(score) ? mover : SearchIsLoss(score) ? Opponent(mover) : EMPTY;
+}
+
+static void EvaluateOne(const BatchConfig *config, Search *search, const PackedPosition *position, BatchResult *result)
+{
+    Board board;
+    result->score = 0;
+    result->move = -1;
+    result->winner = EMPTY;
+    if (!BatchUnpack(position, config->geo, &board)) return;
+
+    // Finished games are scored as they stand, from the side that would move next
+    Cell mover = BoardSideToMove(&board);
+    if (BoardHasLine(&board, PLAYER_X) || BoardHasLine(&board, PLAYER_O)) {
+        int score = BoardHasLine(&board, mover) ? SEARCH_WIN : -SEARCH_WIN;
+        SetResult(result, mover, score, -1);
+        return;
+    }
+    if (BoardIsDrawn(&board)) return;
+
+    if (TablebaseCovers(config->tablebase, config->geo)) {
+        unsigned char value;
+        int move = TablebaseBestMove(config->tablebase, &board, &value);
+        if (move != -1) {
+            int distance = TB_DISTANCE(value);
+            int score = TB_RESULT(value) == TB_WIN ? SEARCH_WIN - distance :
+                        TB_RESULT(value) == TB_LOSS ? -(SEARCH_WIN - distance) : 0;
+            SetResult(result, mover, score, move);
+            return;
+        }
+    }
+
+    SearchResult searchResult;
+    int depth = config->depth > 0 ? config->depth : BoardEmptyCount(&board);
+    SearchRun(search, &board, depth, &searchResult);
+    SetResult(result, mover, searchResult.score, searchResult.move);
+}
+
+static void EvaluateRun(void *context, long long first, long long last)
+{
+    BatchRunState *state = context;
+    int worker = SchedulerWorkerIndex(state->scheduler);
+    if (state->searches[worker] == NULL) {
+        state->searches[worker] = SearchCreate(state->config->ttBits > 0 ? state->config->ttBits : BATCH_DEFAULT_TT_BITS);
+        if (state->searches[worker] == NULL) {
+            atomic_store(&state->failed, true);
+            return;
+        }
+    }
+
+    for (long long i = first; i < last; i++) {
+        const BatchEntry *entry = &state->entries[i];
+        if (i > first && SamePosition(&entry->position, &state->entries[i - 1].position)) {
+            state->results[entry->index] = state->results[state->entries[i - 1].index];
+            continue;
+        }
+        EvaluateOne(state->config, state->searches[worker], &entry->position, &state->results[entry->index]);
+    }
+}
+
+bool BatchEvaluate(const BatchConfig *config, const PackedPosition *positions, size_t count, BatchResult *results)
+{
+    if (config->geo->cellCount > BATCH_MAX_CELLS) return false;
+    if (count == 0) return true;
+
+    Scheduler *scheduler = config->scheduler != NULL ? config->scheduler : SchedulerShared();
+    BatchEntry *entries = malloc(sizeof(BatchEntry) * count);
+    Search **searches = scheduler != NULL ? calloc((size_t)SchedulerThreadCount(scheduler), sizeof(Search *)) : NULL;
+    if (entries == NULL || searches == NULL) {
+        free(entries);
+        free(searches);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        entries[i].position = positions[i];
+        entries[i].index = i;
+    }
+    qsort(entries, count, sizeof(BatchEntry), CompareEntries);
+
+    BatchRunState state = {config, scheduler, entries, results, searches, false};
+    SchedulerParallelFor(scheduler, (long long)count, BATCH_CHUNK, EvaluateRun, &state);
+
+    for (int i = 0; i < SchedulerThreadCount(scheduler); i++) SearchDestroy(searches[i]);
+    free(searches);
+    free(entries);
+    return !atomic_load(&state.failed);
+}
+
+int BatchMain(int argc, char **argv, const Tablebase *tablebase)
+{
+    BatchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.geo = BoardGeometryGet(3, 3);
+    config.tablebase = tablebase;
+
+    int size, columns, winLength;
+    if (argc > 1 && (sscanf(argv[1], "%dx%dk%d", &size, &columns, &winLength) != 3 || columns != size ||
+                     (config.geo = BoardGeometryGet(size, winLength)) == NULL)) {
+        argc = 0;
+    }
+    if (argc < 1 || config.geo->cellCount > BATCH_MAX_CELLS) {
+        printf("Usage: [--threads N[:pin]] --batch <file> [NxNkK] [depth]\n");
+        printf("  one position per line: x,o,b,...[,positive|negative]\n");
+        return 1;
+    }
+    if (argc > 2) config.depth = atoi(argv[2]);
+
+    FILE *file = fopen(argv[0], "r");
+    if (file == NULL) {
+        printf("Error opening file!\n");
+        return 1;
+    }
+
+    size_t count = 0, capacity = 1 << 16;
+    PackedPosition *positions = malloc(sizeof(PackedPosition) * capacity);
+    signed char *labels = malloc(capacity);
+    char line[512];
+    long long skipped = 0;
+    while (positions != NULL && labels != NULL && fgets(line, sizeof(line), file)) {
+        int label;
+        if (!BatchParseRow(line, config.geo, &positions[count], &label)) {
+            skipped++;
+            continue;
+        }
+        labels[count++] = (signed char)label;
+        if (count == capacity) {
+            capacity *= 2;
+            PackedPosition *grownPositions = realloc(positions, sizeof(PackedPosition) * capacity);
+            if (grownPositions != NULL) positions = grownPositions;
+            signed char *grownLabels = realloc(labels, capacity);
+            if (grownLabels != NULL) labels = grownLabels;
+            if (grownPositions == NULL || grownLabels == NULL) break;
+        }
+    }
+    fclose(file);
+
+    BatchResult *results = positions != NULL && labels != NULL ? malloc(sizeof(BatchResult) * (count + 1)) : NULL;
+    uint64_t start = TimerNowNs();
+    if (results == NULL || !BatchEvaluate(&config, positions, count, results)) {
+        printf("Error evaluating batch!\n");
+        free(positions);
+        free(labels);
+        free(results);
+        return 1;
+    }
+    double seconds = (double)(TimerNowNs() - start) / 1e9;
+
+    // Labels follow the UCI tic-tac-toe data: positive means X won
+    long long wins[3] = {0, 0, 0}, labelled = 0, correct = 0;
+    for (size_t i = 0; i < count; i++) {
+        wins[results[i].winner]++;
+        if (labels[i] < 0) continue;
+        labelled++;
+        if ((results[i].winner == PLAYER_X) == (labels[i] == 1)) correct++;
+    }
+
+    printf("\nBatch: %zu positions in %.2fs (%.0f positions/sec), %lld rows skipped\n",
+           count, seconds, seconds > 0 ? count / seconds : 0.0, skipped);
+    printf("  X wins: %lld, O wins: %lld, Draws/unresolved: %lld\n", wins[PLAYER_X], wins[PLAYER_O], wins[EMPTY]);
+    if (labelled > 0) printf("  Agrees with labels: %.2f%% of %lld\n", (double)correct / labelled * 100, labelled);
+
+    free(positions);
+    free(labels);
+    free(results);
+    return 0;
+}
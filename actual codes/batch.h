@@ -0,0 +1,55 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "board.h"
+#include "scheduler.h"
+#include "tablebase.h"
+#include <stddef.h>
+
+// Bulk scoring for analysis clients: a whole dataset of positions goes
+// through one call instead of one board at a time. Positions are packed as
+// two cell masks. The batch is sorted so duplicates sit next to each other
+// (and are only solved once) and fuller positions come first, whose results
+// are then already in the search table when emptier positions search into
+// them. The scheduler's workers take runs of the sorted batch, and each
+// keeps its own search, table included, for the whole call.
+
+#define BATCH_MAX_CELLS 64
+#define BATCH_CHUNK 256          // smallest run of positions handed to one worker
+#define BATCH_DEFAULT_TT_BITS 18
+
+typedef struct {
+    uint64_t x;
+    uint64_t o;
+} PackedPosition;
+
+typedef struct {
+    short score;    // for the side to move, SEARCH_WIN - plies for a forced win
+    short move;     // best move, -1 once the game is over
+    Cell winner;    // side with a forced win, EMPTY if none was found
+} BatchResult;
+
+typedef struct {
+    const BoardGeometry *geo;
+    const Tablebase *tablebase;  // optional, probed before searching
+    int depth;                   // search depth, 0 = to the end of the game
+    Scheduler *scheduler;        // NULL = the shared one
+    int ttBits;                  // per-worker table, 0 = BATCH_DEFAULT_TT_BITS
+} BatchConfig;
+
+PackedPosition BatchPack(const Board *board);
+
+// False if the masks don't make a position of this geometry
+bool BatchUnpack(const PackedPosition *position, const BoardGeometry *geo, Board *board);
+
+// Reads one "x,o,b,...[,positive|negative]" row. The label is 1 for
+// positive, 0 for negative and -1 when the row has none.
+bool BatchParseRow(const char *line, const BoardGeometry *geo, PackedPosition *position, int *label);
+
+// Scores positions[0..count) into results[0..count), in the caller's order
+bool BatchEvaluate(const BatchConfig *config, const PackedPosition *positions, size_t count, BatchResult *results);
+
+// Entry point for "--batch <file> [NxNkK] [depth]"
+int BatchMain(int argc, char **argv, const Tablebase *tablebase);
+
+#endif // BATCH_H
@@ -0,0 +1,237 @@
+#include "board.h"
+#include "rng.h"
+#include <stdlib.h>
+
+#define MAX_CACHED_GEOMETRIES 8
+#define HASH_SEED 0x7469637461636B73ULL // fixed so hashes are stable between runs
+
+static BoardGeometry *cachedGeometries[MAX_CACHED_GEOMETRIES];
+static int cachedGeometryCount = 0;
+// Zobrist keys: one per cell and side, indexed by cell number so every board
+// size up to BOARD_MAX_SIZE shares the table, plus one for O to move
+static uint64_t cellKeys[2][BOARD_MAX_CELLS];
+static uint64_t sideKey;
+
+static void InitZobristKeys(void)
+{
+    uint64_t state = RngSeed(HASH_SEED);
+    for (int side = 0; side < 2; side++) {
+        for (int cell = 0; cell < BOARD_MAX_CELLS; cell++) {
+            cellKeys[side][cell] = RngNext(&state);
+        }
+    }
+    sideKey = RngNext(&state);
+}
+
+static void BuildSymmetries(BoardGeometry *geo)
+{
+    int n = geo->size;
+    for (int row = 0; row < n; row++) {
+        for (int col = 0; col < n; col++) {
+            int cell = row * n + col;
+            geo->symmetry[0][cell] = (unsigned short)cell;
+            geo->symmetry[1][cell] = (unsigned short)(col * n + (n - 1 - row));             // rotate 90
+            geo->symmetry[2][cell] = (unsigned short)((n - 1 - row) * n + (n - 1 - col));   // rotate 180
+            geo->symmetry[3][cell] = (unsigned short)((n - 1 - col) * n + row);             // rotate 270
+            geo->symmetry[4][cell] = (unsigned short)(row * n + (n - 1 - col));             // mirror left-right
+            geo->symmetry[5][cell] = (unsigned short)((n - 1 - row) * n + col);             // mirror top-bottom
+            geo->symmetry[6][cell] = (unsigned short)(col * n + row);                       // transpose
+            geo->symmetry[7][cell] = (unsigned short)((n - 1 - col) * n + (n - 1 - row));   // anti-transpose
+        }
+    }
+
+    for (int s = 0; s < BOARD_SYMMETRIES; s++) {
+        for (int t = 0; t < BOARD_SYMMETRIES; t++) {
+            if (geo->symmetry[t][geo->symmetry[s][1]] == 1 && geo->symmetry[t][geo->symmetry[s][n]] == n) {
+                geo->inverseSymmetry[s] = (unsigned char)t;
+            }
+        }
+    }
+}
+
+static void BuildGeometry(BoardGeometry *geo, int size, int winLength)
+{
+    static const int directions[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+
+    memset(geo, 0, sizeof(*geo));
+    geo->size = size;
+    geo->winLength = winLength;
+    geo->cellCount = size * size;
+    geo->words = (geo->cellCount + 63) / 64;
+
+    for (int d = 0; d < 4; d++) {
+        for (int row = 0; row < size; row++) {
+            for (int col = 0; col < size; col++) {
+                int endRow = row + directions[d][0] * (winLength - 1);
+                int endCol = col + directions[d][1] * (winLength - 1);
+                if (endRow < 0 || endRow >= size || endCol < 0 || endCol >= size) continue;
+
+                int line = geo->lineCount++;
+                for (int k = 0; k < winLength; k++) {
+                    int cell = (row + directions[d][0] * k) * size + (col + directions[d][1] * k);
+                    geo->lineCells[line][k] = (unsigned short)cell;
+                    BitboardSet(&geo->lineMask[line], cell);
+                    geo->cellLines[cell][geo->cellLineCount[cell]++] = (unsigned short)line;
+                }
+            }
+        }
+    }
+    BuildSymmetries(geo);
+}
+
+const BoardGeometry *BoardGeometryGet(int size, int winLength)
+{
+    if (size < 1 || size > BOARD_MAX_SIZE) return NULL;
+    if (winLength < BOARD_MIN_WIN_LENGTH || winLength > size) return NULL;
+
+    for (int i = 0; i < cachedGeometryCount; i++) {
+        if (cachedGeometries[i]->size == size && cachedGeometries[i]->winLength == winLength) {
+            return cachedGeometries[i];
+        }
+    }
+    if (cachedGeometryCount == MAX_CACHED_GEOMETRIES) return NULL;
+
+    BoardGeometry *geo = malloc(sizeof(BoardGeometry));
+    if (geo == NULL) return NULL;
+    if (cachedGeometryCount == 0) InitZobristKeys();
+    BuildGeometry(geo, size, winLength);
+    cachedGeometries[cachedGeometryCount++] = geo;
+    return geo;
+}
+
+void BoardInit(Board *board, const BoardGeometry *geo)
+{
+    memset(board, 0, sizeof(*board));
+    board->geo = geo;
+    board->openLines[0] = geo->lineCount;
+    board->openLines[1] = geo->lineCount;
+}
+
+// Every piece change flips the side to move as well
+static void UpdateHashes(Board *board, int cell, int side)
+{
+    const BoardGeometry *geo = board->geo;
+    for (int s = 0; s < BOARD_SYMMETRIES; s++) {
+        board->hashes[s] ^= cellKeys[side][geo->symmetry[s][cell]] ^ sideKey;
+    }
+}
+
+static void AddPiece(Board *board, int cell, int side)
+{
+    const BoardGeometry *geo = board->geo;
+    unsigned char *own = board->lineCount[side];
+    const unsigned char *other = board->lineCount[side ^ 1];
+
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) {
+        int line = geo->cellLines[cell][i];
+        if (own[line] == 0 && other[line] == 0) board->openLines[side ^ 1]--;
+        if (++own[line] == geo->winLength) board->completedLines[side]++;
+    }
+    BitboardSet(&board->pieces[side], cell);
+    board->filled++;
+    UpdateHashes(board, cell, side);
+}
+
+static void RemovePiece(Board *board, int cell, int side)
+{
+    const BoardGeometry *geo = board->geo;
+    unsigned char *own = board->lineCount[side];
+    const unsigned char *other = board->lineCount[side ^ 1];
+
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) {
+        int line = geo->cellLines[cell][i];
+        if (own[line]-- == geo->winLength) board->completedLines[side]--;
+        if (own[line] == 0 && other[line] == 0) board->openLines[side ^ 1]++;
+    }
+    BitboardClear(&board->pieces[side], cell);
+    board->filled--;
+    UpdateHashes(board, cell, side);
+}
+
+void BoardFromCells(Board *board, const BoardGeometry *geo, const Cell *cells)
+{
+    BoardInit(board, geo);
+    for (int i = 0; i < geo->cellCount; i++) {
+        if (cells[i] != EMPTY) BoardSetCell(board, i, cells[i]);
+    }
+}
+
+void BoardToCells(const Board *board, Cell *cells)
+{
+    for (int i = 0; i < board->geo->cellCount; i++) {
+        cells[i] = BoardGetCell(board, i);
+    }
+}
+
+void BoardSetCell(Board *board, int cell, Cell value)
+{
+    Cell previous = BoardGetCell(board, cell);
+    if (previous == value) return;
+
+    if (previous != EMPTY) RemovePiece(board, cell, SideIndex(previous));
+    if (value != EMPTY) AddPiece(board, cell, SideIndex(value));
+}
+
+void BoardMakeMove(Board *board, int cell, Cell player)
+{
+    AddPiece(board, cell, SideIndex(player));
+    board->moves[board->ply++] = (unsigned short)(cell | (player == PLAYER_O ? BOARD_MOVE_O : 0));
+    board->moveCount = board->ply;
+}
+
+int BoardUnmakeMove(Board *board)
+{
+    if (board->ply == 0) return -1;
+
+    int move = board->moves[--board->ply];
+    int cell = move & ~BOARD_MOVE_O;
+    RemovePiece(board, cell, (move & BOARD_MOVE_O) ? 1 : 0);
+    return cell;
+}
+
+int BoardRedoMove(Board *board)
+{
+    if (board->ply == board->moveCount) return -1;
+
+    int move = board->moves[board->ply++];
+    int cell = move & ~BOARD_MOVE_O;
+    AddPiece(board, cell, (move & BOARD_MOVE_O) ? 1 : 0);
+    return cell;
+}
+
+// Only the lines through the last move can have been completed by it
+bool BoardCompletesLine(const Board *board, int cell, Cell player)
+{
+    const BoardGeometry *geo = board->geo;
+    const unsigned char *own = board->lineCount[SideIndex(player)];
+
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) {
+        if (own[geo->cellLines[cell][i]] == geo->winLength) return true;
+    }
+    return false;
+}
+
+// Fills cells with the empty cell indices in ascending order and returns how many there are
+int BoardEmptyCells(const Board *board, unsigned short *cells)
+{
+    const BoardGeometry *geo = board->geo;
+    int count = 0;
+
+    for (int i = 0; i < geo->words; i++) {
+        uint64_t empty = ~(board->pieces[0].w[i] | board->pieces[1].w[i]);
+        int bits = geo->cellCount - i * 64;
+        if (bits < 64) empty &= ((uint64_t)1 << bits) - 1;
+
+        while (empty) {
+            cells[count++] = (unsigned short)(i * 64 + __builtin_ctzll(empty));
+            empty &= empty - 1;
+        }
+    }
+    return count;
+}
+
+// X always opens, so the side to move follows from the number of pieces
+Cell BoardSideToMove(const Board *board)
+{
+    return (board->filled % 2 == 0) ? PLAYER_X : PLAYER_O;
+}
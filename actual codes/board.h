@@ -0,0 +1,142 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Board representation shared by the game loop and every engine.
+// Boards are N x N with k-in-a-row to win; the classic game is 3 x 3 with 3.
+
+#define BOARD_MAX_SIZE 15
+#define BOARD_MAX_CELLS (BOARD_MAX_SIZE * BOARD_MAX_SIZE)
+#define BOARD_WORDS ((BOARD_MAX_CELLS + 63) / 64)
+#define BOARD_MIN_WIN_LENGTH 3
+// Worst case is the largest board with the shortest winning line
+#define BOARD_MAX_LINES (2 * BOARD_MAX_SIZE * (BOARD_MAX_SIZE - 2) + 2 * (BOARD_MAX_SIZE - 2) * (BOARD_MAX_SIZE - 2))
+#define BOARD_MAX_CELL_LINES (4 * BOARD_MAX_SIZE)
+#define BOARD_MOVE_O 0x8000
+#define BOARD_SYMMETRIES 8 // rotations and reflections of a square board
+
+typedef enum { EMPTY, PLAYER_X, PLAYER_O } Cell;
+
+typedef struct {
+    uint64_t w[BOARD_WORDS];
+} Bitboard;
+
+typedef struct {
+    int size;       // N
+    int winLength;  // k
+    int cellCount;
+    int words;      // Bitboard words actually in use
+    int lineCount;
+    Bitboard lineMask[BOARD_MAX_LINES];
+    unsigned short lineCells[BOARD_MAX_LINES][BOARD_MAX_SIZE];
+    unsigned short cellLines[BOARD_MAX_CELLS][BOARD_MAX_CELL_LINES];
+    unsigned char cellLineCount[BOARD_MAX_CELLS];
+    unsigned short symmetry[BOARD_SYMMETRIES][BOARD_MAX_CELLS]; // where each cell lands, [0] is the identity
+    unsigned char inverseSymmetry[BOARD_SYMMETRIES];
+} BoardGeometry;
+
+// Besides the bitboards, every line keeps how many pieces each side has on
+// it. Placing or removing a piece only touches the lines through that cell,
+// which keeps win and draw detection O(1).
+typedef struct {
+    const BoardGeometry *geo;
+    Bitboard pieces[2]; // [0] = X, [1] = O
+    int filled;
+    int completedLines[2];
+    int openLines[2];   // lines a side can still complete (no opposing piece on them)
+    unsigned char lineCount[2][BOARD_MAX_LINES];
+    // Zobrist keys of the position under every symmetry, [0] being the
+    // position itself, so canonical lookups never transform the board
+    uint64_t hashes[BOARD_SYMMETRIES];
+    int ply;            // moves on the stack
+    int moveCount;      // ply plus the undone moves that can still be redone
+    unsigned short moves[BOARD_MAX_CELLS]; // cell, with BOARD_MOVE_O set for O's moves
+} Board;
+
+// Geometries are built once and cached; call from the main thread before
+// handing them to worker threads.
+const BoardGeometry *BoardGeometryGet(int size, int winLength);
+
+void BoardInit(Board *board, const BoardGeometry *geo);
+void BoardFromCells(Board *board, const BoardGeometry *geo, const Cell *cells);
+void BoardToCells(const Board *board, Cell *cells);
+void BoardSetCell(Board *board, int cell, Cell value);  // position setup, bypasses the move stack
+
+// Move stack shared by the search and the game loop. Making a move drops
+// any moves that were undone but not redone.
+void BoardMakeMove(Board *board, int cell, Cell player);
+int BoardUnmakeMove(Board *board);  // returns the cell that was cleared, -1 if none
+int BoardRedoMove(Board *board);    // returns the cell that was replayed, -1 if none
+bool BoardCompletesLine(const Board *board, int cell, Cell player);
+int BoardEmptyCells(const Board *board, unsigned short *cells);
+Cell BoardSideToMove(const Board *board);
+
+static inline int SideIndex(Cell player) { return player == PLAYER_O ? 1 : 0; }
+static inline Cell Opponent(Cell player) { return player == PLAYER_X ? PLAYER_O : PLAYER_X; }
+
+static inline bool BitboardTest(const Bitboard *bb, int cell)
+{
+    return (bb->w[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static inline void BitboardSet(Bitboard *bb, int cell)
+{
+    bb->w[cell >> 6] |= (uint64_t)1 << (cell & 63);
+}
+
+static inline void BitboardClear(Bitboard *bb, int cell)
+{
+    bb->w[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+}
+
+static inline bool BitboardContains(const Bitboard *bb, const Bitboard *mask, int words)
+{
+    for (int i = 0; i < words; i++) {
+        if ((bb->w[i] & mask->w[i]) != mask->w[i]) return false;
+    }
+    return true;
+}
+
+static inline Cell BoardGetCell(const Board *board, int cell)
+{
+    if (BitboardTest(&board->pieces[0], cell)) return PLAYER_X;
+    if (BitboardTest(&board->pieces[1], cell)) return PLAYER_O;
+    return EMPTY;
+}
+
+static inline int BoardEmptyCount(const Board *board)
+{
+    return board->geo->cellCount - board->filled;
+}
+
+static inline int BoardPly(const Board *board) { return board->ply; }
+static inline uint64_t BoardHash(const Board *board) { return board->hashes[0]; }
+
+// Smallest key among the symmetric variants; symmetry receives the transform
+// that maps this position onto the canonical one
+static inline uint64_t BoardCanonicalHash(const Board *board, int *symmetry)
+{
+    int best = 0;
+    for (int s = 1; s < BOARD_SYMMETRIES; s++) {
+        if (board->hashes[s] < board->hashes[best]) best = s;
+    }
+    if (symmetry != NULL) *symmetry = best;
+    return board->hashes[best];
+}
+
+static inline bool BoardHasLine(const Board *board, Cell player)
+{
+    return board->completedLines[SideIndex(player)] > 0;
+}
+
+// Full, or no line is left that either side could still complete
+static inline bool BoardIsDrawn(const Board *board)
+{
+    if (board->completedLines[0] > 0 || board->completedLines[1] > 0) return false;
+    return board->filled == board->geo->cellCount || (board->openLines[0] == 0 && board->openLines[1] == 0);
+}
+
+#endif // BOARD_H
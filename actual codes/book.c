@@ -0,0 +1,241 @@
+#include "book.h"
+#include "search.h"
+#include <stdlib.h>
+
+#include "book_data.h" // embeddedBooks[], generated by --build-book
+
+typedef struct {
+    uint64_t key;
+    unsigned short move;
+} BookEntry;
+
+typedef struct {
+    const BoardGeometry *geo;
+    int plies;
+    int depth;
+    Search *search;
+    BookEntry *entries;
+    int count;
+    int capacity;
+    // Canonical keys already searched, so transpositions and symmetric
+    // copies are only visited once
+    uint64_t *seenKeys;
+    bool *seenUsed;
+    size_t seenMask;
+    size_t seenCount;
+} BookBuilder;
+
+const OpeningBook *BookFind(const BoardGeometry *geo)
+{
+    for (size_t i = 0; i < sizeof(embeddedBooks) / sizeof(embeddedBooks[0]); i++) {
+        if (embeddedBooks[i].size == geo->size && embeddedBooks[i].winLength == geo->winLength) return &embeddedBooks[i];
+    }
+    return NULL;
+}
+
+int BookProbe(const Board *board)
+{
+    const OpeningBook *book = BookFind(board->geo);
+    if (book == NULL || board->filled >= book->plies) return -1;
+
+    int symmetry;
+    uint64_t key = BoardCanonicalHash(board, &symmetry);
+    int low = 0, high = book->count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (book->keys[mid] < key) {
+            low = mid + 1;
+        } else if (book->keys[mid] > key) {
+            high = mid - 1;
+        } else {
+            // Undo the symmetry that made the position canonical
+            const BoardGeometry *geo = board->geo;
+            int move = geo->symmetry[geo->inverseSymmetry[symmetry]][book->moves[mid]];
+            return BoardGetCell(board, move) == EMPTY ? move : -1;
+        }
+    }
+    return -1;
+}
+
+// Adds the key to the seen set; false if it was already there
+static bool MarkSeen(BookBuilder *builder, uint64_t key)
+{
+    if (builder->seenCount * 2 >= builder->seenMask + 1) {
+        // Keep the set at most half full
+        size_t oldSize = builder->seenMask + 1;
+        uint64_t *oldKeys = builder->seenKeys;
+        bool *oldUsed = builder->seenUsed;
+        uint64_t *keys = calloc(oldSize * 2, sizeof(uint64_t));
+        bool *used = calloc(oldSize * 2, sizeof(bool));
+        if (keys == NULL || used == NULL) {
+            free(keys);
+            free(used);
+            return false;
+        }
+
+        builder->seenKeys = keys;
+        builder->seenUsed = used;
+        builder->seenMask = oldSize * 2 - 1;
+        builder->seenCount = 0;
+        for (size_t i = 0; i < oldSize; i++) {
+            if (oldUsed[i]) MarkSeen(builder, oldKeys[i]);
+        }
+        free(oldKeys);
+        free(oldUsed);
+    }
+
+    size_t slot = (size_t)(key ^ (key >> 29)) & builder->seenMask;
+    while (builder->seenUsed[slot]) {
+        if (builder->seenKeys[slot] == key) return false;
+        slot = (slot + 1) & builder->seenMask;
+    }
+    builder->seenUsed[slot] = true;
+    builder->seenKeys[slot] = key;
+    builder->seenCount++;
+    return true;
+}
+
+static bool AddEntry(BookBuilder *builder, uint64_t key, int move)
+{
+    if (builder->count == builder->capacity) {
+        int capacity = builder->capacity ? builder->capacity * 2 : 256;
+        BookEntry *entries = realloc(builder->entries, sizeof(BookEntry) * (size_t)capacity);
+        if (entries == NULL) return false;
+        builder->entries = entries;
+        builder->capacity = capacity;
+    }
+    builder->entries[builder->count].key = key;
+    builder->entries[builder->count].move = (unsigned short)move;
+    builder->count++;
+    return true;
+}
+
+static bool Visit(BookBuilder *builder, Board *board)
+{
+    if (board->filled >= builder->plies || BoardIsDrawn(board)) return true;
+    if (BoardHasLine(board, PLAYER_X) || BoardHasLine(board, PLAYER_O)) return true;
+
+    int symmetry;
+    uint64_t key = BoardCanonicalHash(board, &symmetry);
+    if (!MarkSeen(builder, key)) return true;
+
+    SearchResult result;
+    if (SearchRun(builder->search, board, builder->depth, &result)) {
+        if (!AddEntry(builder, key, builder->geo->symmetry[symmetry][result.move])) return false;
+    }
+
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, cells);
+    Cell player = BoardSideToMove(board);
+    for (int i = 0; i < count; i++) {
+        BoardMakeMove(board, cells[i], player);
+        bool ok = Visit(builder, board);
+        BoardUnmakeMove(board);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static int CompareEntries(const void *a, const void *b)
+{
+    uint64_t keyA = ((const BookEntry *)a)->key;
+    uint64_t keyB = ((const BookEntry *)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+bool BookBuild(FILE *out, const BoardGeometry *geo, int plies, int searchDepth)
+{
+    BookBuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.geo = geo;
+    builder.plies = plies;
+    builder.depth = searchDepth;
+    builder.search = SearchCreate(SEARCH_DEFAULT_TT_BITS + 4);
+    builder.seenMask = 1023;
+    builder.seenKeys = calloc(builder.seenMask + 1, sizeof(uint64_t));
+    builder.seenUsed = calloc(builder.seenMask + 1, sizeof(bool));
+
+    Board board;
+    BoardInit(&board, geo);
+    bool ok = builder.search != NULL && builder.seenKeys != NULL && builder.seenUsed != NULL &&
+              Visit(&builder, &board) && builder.count > 0;
+
+    if (ok) {
+        qsort(builder.entries, builder.count, sizeof(BookEntry), CompareEntries);
+        fprintf(out, "// %dx%d, %d in a row: %d positions with fewer than %d moves played, searched %d plies deep\n",
+                geo->size, geo->size, geo->winLength, builder.count, plies, searchDepth);
+        fprintf(out, "static const uint64_t book%dx%dk%dKeys[] = {", geo->size, geo->size, geo->winLength);
+        for (int i = 0; i < builder.count; i++) {
+            fprintf(out, "%s0x%016llxull,", i % 4 == 0 ? "\n    " : " ", (unsigned long long)builder.entries[i].key);
+        }
+        fprintf(out, "\n};\n");
+        fprintf(out, "static const unsigned short book%dx%dk%dMoves[] = {", geo->size, geo->size, geo->winLength);
+        for (int i = 0; i < builder.count; i++) {
+            fprintf(out, "%s%d,", i % 16 == 0 ? "\n    " : " ", builder.entries[i].move);
+        }
+        fprintf(out, "\n};\n\n");
+    }
+
+    SearchDestroy(builder.search);
+    free(builder.entries);
+    free(builder.seenKeys);
+    free(builder.seenUsed);
+    return ok;
+}
+
+int BookMain(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("Usage: --build-book <file> <NxNkK[:plies[:depth]]>...\n");
+        return 1;
+    }
+
+    FILE *out = fopen(argv[0], "w");
+    if (out == NULL) {
+        printf("Error opening file!\n");
+        return 1;
+    }
+
+    fprintf(out, "// Generated by `actualmain --build-book");
+    for (int i = 0; i < argc; i++) fprintf(out, " %s", argv[i]);
+    fprintf(out, "`, do not edit.\n\n");
+
+    int sizes[16], winLengths[16], plies[16];
+    int books = 0;
+    for (int i = 1; i < argc && books < 16; i++) {
+        int size, columns, winLength, depth = -1;
+        plies[books] = -1;
+        if (sscanf(argv[i], "%dx%dk%d:%d:%d", &size, &columns, &winLength, &plies[books], &depth) < 3 || columns != size) {
+            printf("Bad book spec: %s\n", argv[i]);
+            continue;
+        }
+        const BoardGeometry *geo = BoardGeometryGet(size, winLength);
+        if (geo == NULL) {
+            printf("Bad book spec: %s\n", argv[i]);
+            continue;
+        }
+
+        // Bigger boards get more plies but a shallower search per position
+        if (plies[books] < 0) plies[books] = size + 1;
+        if (depth < 0) depth = geo->cellCount <= 16 ? geo->cellCount : 8;
+
+        printf("Building %dx%d k%d book (%d plies, depth %d)...\n", size, size, winLength, plies[books], depth);
+        if (!BookBuild(out, geo, plies[books], depth)) {
+            printf("Error building book!\n");
+            continue;
+        }
+        sizes[books] = size;
+        winLengths[books] = winLength;
+        books++;
+    }
+
+    fprintf(out, "static const OpeningBook embeddedBooks[] = {\n");
+    for (int i = 0; i < books; i++) {
+        fprintf(out, "    {%d, %d, %d, (int)(sizeof(book%dx%dk%dKeys) / sizeof(uint64_t)), book%dx%dk%dKeys, book%dx%dk%dMoves},\n",
+                sizes[i], winLengths[i], plies[i], sizes[i], sizes[i], winLengths[i],
+                sizes[i], sizes[i], winLengths[i], sizes[i], sizes[i], winLengths[i]);
+    }
+    fprintf(out, "};\n");
+    fclose(out);
+    return books > 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "board.h"
+#include <stdio.h>
+
+// Opening book: best replies for the first few plies, worked out offline
+// by a full search and compiled into the program (book_data.h), so the
+// most expensive searches of a game never run at all.
+//
+// Each book is a table of canonical position keys sorted for binary search,
+// next to the best move in that canonical orientation. A probe maps the
+// move back onto the board through the symmetry the key came from.
+
+typedef struct {
+    int size;
+    int winLength;
+    int plies;                      // positions with fewer moves played are covered
+    int count;
+    const uint64_t *keys;           // sorted canonical keys
+    const unsigned short *moves;    // best reply, in the canonical orientation
+} OpeningBook;
+
+const OpeningBook *BookFind(const BoardGeometry *geo);
+
+// Book move for the side to move, -1 if the position isn't in the book
+int BookProbe(const Board *board);
+
+// Searches every position up to `plies` moves deep (searchDepth plies each)
+// and appends the resulting table to a generated C file
+bool BookBuild(FILE *out, const BoardGeometry *geo, int plies, int searchDepth);
+
+// Entry point for "--build-book <file> <NxNkK[:plies[:depth]]>..."
+int BookMain(int argc, char **argv);
+
+#endif // BOOK_H
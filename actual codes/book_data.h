@@ -0,0 +1,29 @@
+// Generated by `actualmain --build-book book_data.h 3x3k3:4`, do not edit.
+
+// 3x3, 3 in a row: 54 positions with fewer than 4 moves played, searched 9 plies deep
+static const uint64_t book3x3k3Keys[] = {
+    0x0000000000000000ull, 0x006679412d0a12baull, 0x0096a8fe4df8f719ull, 0x00eb7960192af43eull,
+    0x01b506cf4f9e0b0eull, 0x024910e51543d835ull, 0x03176f4a43f72705ull, 0x05bc3425897e6096ull,
+    0x05c838e9f3e6a4ecull, 0x05fcfc22bb7cf995ull, 0x070da5549eca5c4bull, 0x0746ccf86e5f681dull,
+    0x07f306aa6980afd3ull, 0x09eb487ff6b591d5ull, 0x0a72f0b13fe98b99ull, 0x0acb127e5d4a47b7ull,
+    0x0ce494628da921fdull, 0x0d5e6d9519c0fadeull, 0x0de78f5a7b6336f0ull, 0x112bf5e8e1fe0b37ull,
+    0x1141a434a988126dull, 0x12912f8a628521acull, 0x1362e50df4bdd302ull, 0x13cf50253431de9cull,
+    0x150a2220b1b78afeull, 0x166d39108fa1632aull, 0x16ec11acdefd8e4eull, 0x18484879685db0dbull,
+    0x194a1bb043451b27ull, 0x19e335830b341126ull, 0x1b590559de1780aeull, 0x1beccf0bd9c84760ull,
+    0x1ccc7ab29a9d3dc7ull, 0x2077eb3ed6eb684bull, 0x25aceeabaf4da696ull, 0x277356b0f7f689baull,
+    0x27e5fe4eba0e7ea3ull, 0x292e03880fee95d1ull, 0x29bb5af6e284ced6ull, 0x2b016a2c37a75f5eull,
+    0x31743e7c3021f3caull, 0x334f003faa47f8f5ull, 0x33e62e0ce236f2f4ull, 0x41a119ab691aa82full,
+    0x4ca1c70c6e2f6101ull, 0x4cadef910b536ae1ull, 0x4e509e7a4b99c4dfull, 0x550418e2a2a4fe54ull,
+    0x58007b7b33754736ull, 0x5aa6afc0a9f81b71ull, 0x62c9087c0f9e9ccdull, 0x640208381da0de94ull,
+    0x7ae739444ac93eacull, 0xdf9467d25e30dca8ull,
+};
+static const unsigned short book3x3k3Moves[] = {
+    0, 2, 7, 8, 1, 8, 6, 3, 7, 1, 4, 2, 4, 6, 4, 3,
+    2, 6, 5, 6, 2, 4, 6, 6, 6, 1, 0, 1, 6, 1, 7, 5,
+    5, 4, 6, 7, 4, 8, 4, 2, 4, 6, 1, 0, 3, 4, 2, 8,
+    0, 3, 2, 7, 0, 0,
+};
+
+static const OpeningBook embeddedBooks[] = {
+    {3, 3, 4, (int)(sizeof(book3x3k3Keys) / sizeof(uint64_t)), book3x3k3Keys, book3x3k3Moves},
+};
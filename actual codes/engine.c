@@ -0,0 +1,256 @@
+#include "engine.h"
+#include "rng.h"
+#include "trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const int defaultPlayouts[3] = {50, 1000, 20000}; // MCTS budget for EASY, MEDIUM and HARD
+
+EngineConfig EngineConfigDefault(EngineType type, Difficulty difficulty)
+{
+    EngineConfig config;
+    config.type = type;
+    config.difficulty = difficulty;
+    config.depthLimit = (difficulty == HARD) ? 9 : 3;
+    config.randomPercent = 40;
+    config.playouts = defaultPlayouts[difficulty];
+    config.useTablebase = (difficulty == HARD);
+    config.useBook = (difficulty == HARD);
+    config.useNegamax = true;
+    config.useEvaluation = true;
+    config.threatDepth = (difficulty == HARD) ? THREAT_DEFAULT_DEPTH : 0;
+    config.threatBudgetUs = THREAT_DEFAULT_BUDGET_US;
+    return config;
+}
+
+bool EngineConfigParse(const char *spec, EngineConfig *config)
+{
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+
+    // The engine type and difficulty come first so that settings can override their defaults
+    EngineType type = strncmp(buffer, "mcts", 4) == 0 ? ENGINE_MCTS : ENGINE_MINIMAX;
+    Difficulty difficulty = strstr(buffer, "easy") ? EASY : strstr(buffer, "hard") ? HARD : MEDIUM;
+    *config = EngineConfigDefault(type, difficulty);
+
+    for (char *token = strtok(buffer, ":"); token != NULL; token = strtok(NULL, ":")) {
+        int value;
+        if (strcmp(token, "minimax") == 0 || strcmp(token, "mcts") == 0 || strcmp(token, "easy") == 0 ||
+            strcmp(token, "medium") == 0 || strcmp(token, "hard") == 0) continue;
+        else if (sscanf(token, "depth=%d", &value) == 1) config->depthLimit = value;
+        else if (sscanf(token, "random=%d", &value) == 1) config->randomPercent = value;
+        else if (sscanf(token, "playouts=%d", &value) == 1) config->playouts = value;
+        else if (sscanf(token, "tablebase=%d", &value) == 1) config->useTablebase = value != 0;
+        else if (sscanf(token, "book=%d", &value) == 1) config->useBook = value != 0;
+        else if (sscanf(token, "negamax=%d", &value) == 1) config->useNegamax = value != 0;
+        else if (sscanf(token, "eval=%d", &value) == 1) config->useEvaluation = value != 0;
+        else if (sscanf(token, "threats=%d", &value) == 1) config->threatDepth = value;
+        else if (sscanf(token, "budget=%d", &value) == 1) config->threatBudgetUs = value;
+        else return false;
+    }
+    return true;
+}
+
+const char *EngineConfigName(const EngineConfig *config, char *buffer, int size)
+{
+    static const char *difficultyNames[] = {"easy", "medium", "hard"};
+    if (config->type == ENGINE_MCTS) {
+        snprintf(buffer, size, "mcts:%s:playouts=%d", difficultyNames[config->difficulty], config->playouts);
+    } else if (config->difficulty == EASY) {
+        snprintf(buffer, size, "minimax:easy:random=%d", config->randomPercent);
+    } else {
+        snprintf(buffer, size, "minimax:%s:depth=%d%s%s%s", difficultyNames[config->difficulty], config->depthLimit,
+                 config->useTablebase ? ":tablebase=1" : "", config->useNegamax ? "" : ":negamax=0",
+                 config->useEvaluation ? "" : ":eval=0");
+    }
+    int length = (int)strlen(buffer);
+    if (config->useBook) {
+        snprintf(buffer + length, size - length, ":book=1");
+        length = (int)strlen(buffer);
+    }
+    if (config->threatDepth > 0) {
+        snprintf(buffer + length, size - length, ":threats=%d", config->threatDepth);
+    }
+    return buffer;
+}
+
+void EngineInit(Engine *engine, const EngineConfig *config, const Tablebase *tablebase, uint64_t seed)
+{
+    memset(engine, 0, sizeof(*engine));
+    engine->config = *config;
+    engine->tablebase = tablebase;
+    engine->rng = RngSeed(seed);
+}
+
+void EngineFree(Engine *engine)
+{
+    if (engine->mcts.nodes != NULL) MctsFree(&engine->mcts);
+    SearchDestroy(engine->search);
+    engine->search = NULL;
+    if (engine->threats.table != NULL) ThreatSearchFree(&engine->threats);
+}
+
+// Easy mode: a random move some of the time, otherwise the move the learned
+// model rates best, or the first empty cell without a model
+static int ChooseEasyMove(Engine *engine, Board *board)
+{
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, cells);
+    if (count == 0) return -1;
+
+    if (RngRange(&engine->rng, 100) < engine->config.randomPercent) {
+        return cells[RngRange(&engine->rng, count)];
+    }
+
+    const LinearModel *model = engine->model;
+    if (model == NULL || board->geo->cellCount != LEARNER_FEATURES) return cells[0];
+
+    // The model estimates X's chances, which O wants as low as they go
+    Cell player = BoardSideToMove(board);
+    int bestMove = cells[0];
+    float bestScore = 0.0f;
+    for (int i = 0; i < count; i++) {
+        BoardMakeMove(board, cells[i], player);
+        float score = LinearModelPredict(model, board);
+        BoardUnmakeMove(board);
+        if (player == PLAYER_O) score = -score;
+        if (i == 0 || score > bestScore) {
+            bestScore = score;
+            bestMove = cells[i];
+        }
+    }
+    return bestMove;
+}
+
+// Minimax scores positions for O, so X looks for the lowest score instead
+static int ChooseMinimaxMove(Engine *engine, Board *board)
+{
+    if (engine->config.useNegamax) {
+        if (engine->search == NULL) engine->search = SearchCreate(SEARCH_DEFAULT_TT_BITS);
+        if (engine->search != NULL) {
+            engine->search->useEvaluation = engine->config.useEvaluation;
+            engine->search->deadline = engine->deadline;
+            engine->search->stop = engine->stop;
+            engine->search->progress = engine->progress;
+            engine->search->progressContext = engine->progressContext;
+        }
+        if (engine->search != NULL && SearchRun(engine->search, board, engine->config.depthLimit, &engine->lastResult)) {
+            return engine->lastResult.move;
+        }
+
+        // Stopped before a single root move was searched: any legal move beats overrunning the limit
+        if (engine->search != NULL && engine->search->aborted) {
+            unsigned short cells[BOARD_MAX_CELLS];
+            return BoardEmptyCells(board, cells) > 0 ? cells[0] : -1;
+        }
+    }
+
+    Cell player = BoardSideToMove(board);
+    int bestScore = (player == PLAYER_O) ? -SEARCH_INFINITY : SEARCH_INFINITY;
+    int bestMove = -1;
+
+    for (int cell = 0; cell < board->geo->cellCount; cell++) {
+        if (BoardGetCell(board, cell) != EMPTY) continue;
+
+        BoardMakeMove(board, cell, player);
+        int score = Minimax(board, player == PLAYER_X, 0, engine->config.depthLimit, engine->config.useEvaluation);
+        BoardUnmakeMove(board);
+
+        if ((player == PLAYER_O && score > bestScore) || (player == PLAYER_X && score < bestScore)) {
+            bestScore = score;
+            bestMove = cell;
+        }
+    }
+    return bestMove;
+}
+
+int EngineChooseMove(Engine *engine, Board *board)
+{
+    const EngineConfig *config = &engine->config;
+
+    // Opening positions were searched ahead of time
+    if (config->useBook) {
+        int move = BookProbe(board);
+        if (move != -1) return move;
+    }
+
+    // A forced win found by the threat search is played without searching further
+    engine->lastThreat.win = false;
+    if (config->threatDepth > 0 && (engine->threats.table != NULL || ThreatSearchInit(&engine->threats, THREAT_DEFAULT_TABLE_BITS))) {
+        if (ThreatSearchRun(&engine->threats, board, config->threatDepth, config->threatBudgetUs, &engine->lastThreat)) {
+            return engine->lastThreat.move;
+        }
+    }
+
+    if (config->type == ENGINE_MCTS) {
+        if (engine->mcts.nodes == NULL && !MctsInit(&engine->mcts, MCTS_DEFAULT_NODES, RngNext(&engine->rng))) {
+            return ChooseEasyMove(engine, board);
+        }
+        MctsSetPosition(&engine->mcts, board);
+        engine->mcts.deadline = engine->deadline;
+        engine->mcts.stop = engine->stop;
+        TRACE_BEGIN("MctsSearch");
+        int move = MctsSearch(&engine->mcts, config->playouts);
+        TRACE_END("MctsSearch");
+        return move;
+    }
+
+    if (config->difficulty == EASY) return ChooseEasyMove(engine, board);
+
+    // Perfect play straight from the tablebase once few cells are left
+    if (config->useTablebase && engine->tablebase != NULL) {
+        int move = TablebaseBestMove(engine->tablebase, board, NULL);
+        if (move != -1) return move;
+    }
+    TRACE_BEGIN("Minimax");
+    int move = ChooseMinimaxMove(engine, board);
+    TRACE_END("Minimax");
+    return move;
+}
+
+// Minimax algorithm
+int Minimax(Board *board, bool isMaximizing, int depth, int depthLimit, bool useEvaluation)
+{
+    int score = EvaluateBoard(board);
+    if (score == 10) return SEARCH_WIN - depth; // O (AI) is the maximizing player
+    if (score == -10) return -SEARCH_WIN + depth; // X (human) is the minimizing player
+    if (BoardIsDrawn(board)) return 0; // Draw, including lines that can no longer be completed
+    if (depth >= depthLimit) return useEvaluation ? EvaluatePosition(board, PLAYER_O) : 0; // Static estimate, or a draw, once the depth limit is reached
+
+    if (isMaximizing)
+    {
+        int bestScore = -SEARCH_INFINITY;
+        for (int cell = 0; cell < board->geo->cellCount; cell++)
+        {
+            if (BoardGetCell(board, cell) == EMPTY)
+            {
+                BoardMakeMove(board, cell, PLAYER_O);
+                bestScore = fmax(bestScore, Minimax(board, false, depth + 1, depthLimit, useEvaluation));
+                BoardUnmakeMove(board);
+            }
+        }
+        return bestScore;
+    }
+    else
+    {
+        int bestScore = SEARCH_INFINITY;
+        for (int cell = 0; cell < board->geo->cellCount; cell++)
+        {
+            if (BoardGetCell(board, cell) == EMPTY)
+            {
+                BoardMakeMove(board, cell, PLAYER_X);
+                bestScore = fmin(bestScore, Minimax(board, true, depth + 1, depthLimit, useEvaluation));
+                BoardUnmakeMove(board);
+            }
+        }
+        return bestScore;
+    }
+}
+
+int EvaluateBoard(const Board *board)
+{
+    if (BoardHasLine(board, PLAYER_O)) return 10;
+    if (BoardHasLine(board, PLAYER_X)) return -10;
+    return 0; // No winner
+}
@@ -0,0 +1,70 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "board.h"
+#include "book.h"
+#include "learner.h"
+#include "mcts.h"
+#include "search.h"
+#include "tablebase.h"
+#include "threats.h"
+
+// AI move selection, independent of the UI so that several engines can
+// play at once (the game itself, the headless arena, ...).
+
+typedef enum { EASY, MEDIUM, HARD } Difficulty;
+typedef enum { ENGINE_MINIMAX, ENGINE_MCTS } EngineType;
+
+typedef struct {
+    int wins;
+    int losses;
+    int draws;
+    int totalGames;
+} DifficultyStats;
+
+typedef struct {
+    EngineType type;
+    Difficulty difficulty;
+    int depthLimit;     // Minimax depth (MEDIUM and HARD)
+    int randomPercent;  // chance of a random move (EASY)
+    int playouts;       // MCTS playout budget
+    bool useTablebase;  // probe the endgame tablebase before searching (HARD)
+    bool useBook;       // play from the built-in opening book when it has the position (HARD)
+    bool useNegamax;    // PVS negamax instead of the plain Minimax (MEDIUM and HARD)
+    bool useEvaluation; // static evaluation at the negamax depth limit instead of calling it a draw
+    int threatDepth;    // threat-space pre-pass depth in attacker moves, 0 = off (HARD)
+    int threatBudgetUs; // time the pre-pass may take
+} EngineConfig;
+
+typedef struct {
+    EngineConfig config;
+    const Tablebase *tablebase;
+    MctsEngine mcts;    // allocated on the first MCTS search
+    Search *search;     // allocated on the first negamax search
+    SearchResult lastResult;
+    ThreatSearch threats;   // allocated on the first threat search
+    ThreatResult lastThreat;
+    uint64_t deadline;          // limits handed to the negamax and MCTS searches, see Search
+    const atomic_bool *stop;
+    const LinearModel *model;   // learned model for EASY's moves, may be NULL
+    SearchProgress progress;
+    void *progressContext;
+    uint64_t rng;
+} Engine;
+
+EngineConfig EngineConfigDefault(EngineType type, Difficulty difficulty);
+
+// Parses specs like "hard", "minimax:medium:depth=5" or "mcts:easy:playouts=200"
+bool EngineConfigParse(const char *spec, EngineConfig *config);
+const char *EngineConfigName(const EngineConfig *config, char *buffer, int size);
+
+void EngineInit(Engine *engine, const EngineConfig *config, const Tablebase *tablebase, uint64_t seed);
+void EngineFree(Engine *engine);
+
+// Picks a move for the side to move; the board is left unchanged
+int EngineChooseMove(Engine *engine, Board *board);
+
+int Minimax(Board *board, bool isMaximizing, int depth, int depthLimit, bool useEvaluation);
+int EvaluateBoard(const Board *board);
+
+#endif // ENGINE_H
@@ -0,0 +1,76 @@
+#include "eval.h"
+
+static int BitboardCount(const Bitboard *bb, int words)
+{
+    int count = 0;
+    for (int i = 0; i < words; i++) count += __builtin_popcountll(bb->w[i]);
+    return count;
+}
+
+int EvaluatePosition(const Board *board, Cell player)
+{
+    const BoardGeometry *geo = board->geo;
+    const unsigned char *xCount = board->lineCount[0];
+    const unsigned char *oCount = board->lineCount[1];
+    int words = geo->words;
+
+    // Open lines, branch-free over the per-line counters so the compiler can
+    // vectorise it: a line only counts for a side the other hasn't touched,
+    // and more pieces on it count quadratically more
+    int lineScore = 0;
+    for (int line = 0; line < geo->lineCount; line++) {
+        int x = xCount[line], o = oCount[line];
+        lineScore += (o == 0) * x * x - (x == 0) * o * o;
+    }
+
+    // Winning and fork cells per side, straight from the line masks. A cell
+    // seen on a second two-short line moves from `once` into `twice`.
+    Bitboard empty, threats[2], once[2], twice[2];
+    memset(threats, 0, sizeof(threats));
+    memset(once, 0, sizeof(once));
+    memset(twice, 0, sizeof(twice));
+    for (int i = 0; i < words; i++) empty.w[i] = ~(board->pieces[0].w[i] | board->pieces[1].w[i]);
+
+    int nearlyFull = geo->winLength - 2;
+    for (int line = 0; line < geo->lineCount; line++) {
+        if (xCount[line] < nearlyFull && oCount[line] < nearlyFull) continue; // most lines on a big board
+
+        const Bitboard *mask = &geo->lineMask[line];
+        for (int side = 0; side < 2; side++) {
+            if (board->lineCount[1 - side][line] != 0) continue;
+            int missing = geo->winLength - board->lineCount[side][line];
+            if (missing == 1) {
+                for (int i = 0; i < words; i++) threats[side].w[i] |= mask->w[i] & empty.w[i];
+            } else if (missing == 2) {
+                for (int i = 0; i < words; i++) {
+                    uint64_t cells = mask->w[i] & empty.w[i];
+                    twice[side].w[i] |= once[side].w[i] & cells;
+                    once[side].w[i] |= cells;
+                }
+            }
+        }
+    }
+
+    int me = SideIndex(player);
+    int them = 1 - me;
+    bool toMove = BoardSideToMove(board) == player;
+    int myThreats = BitboardCount(&threats[me], words);
+    int theirThreats = BitboardCount(&threats[them], words);
+
+    // Whoever moves next with a winning cell wins, and two winning cells
+    // can't both be blocked by a side that has none of its own
+    if (toMove && myThreats > 0) return EVAL_MAX;
+    if (!toMove && theirThreats > 0) return -EVAL_MAX;
+    if (!toMove && myThreats > 1) return EVAL_MAX;
+    if (toMove && theirThreats > 1) return -EVAL_MAX;
+
+    int myForks = BitboardCount(&twice[me], words);
+    int theirForks = BitboardCount(&twice[them], words);
+    int score = (me == 0 ? lineScore : -lineScore) +
+                EVAL_THREAT_WEIGHT * (myThreats - theirThreats) +
+                EVAL_FORK_WEIGHT * (myForks - theirForks);
+
+    if (score > EVAL_MAX - 1) score = EVAL_MAX - 1;
+    if (score < -(EVAL_MAX - 1)) score = -(EVAL_MAX - 1);
+    return score;
+}
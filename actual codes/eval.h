@@ -0,0 +1,21 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "board.h"
+
+// Static evaluation for positions where a depth-limited search stops
+// before the game is decided. It looks at every line once:
+//  - open lines (no opposing piece), weighted by how many pieces they hold,
+//  - winning cells: empty cells that complete a line one piece short,
+//  - fork cells: empty cells on two lines two pieces short, where one move
+//    makes two winning cells at once.
+// Scores stay within +-EVAL_MAX, well clear of the search's win scores.
+
+#define EVAL_MAX 500
+#define EVAL_THREAT_WEIGHT 40
+#define EVAL_FORK_WEIGHT 25
+
+// Score from `player`'s point of view
+int EvaluatePosition(const Board *board, Cell player);
+
+#endif // EVAL_H
@@ -0,0 +1,45 @@
+#include "frame.h"
+#include "platform.h"
+#include <stdio.h>
+#include <string.h>
+
+void FramePacerInit(FramePacer *pacer)
+{
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->lastWallNs = TimerNowNs();
+    pacer->lastCpuNs = ProcessCpuNs();
+}
+
+bool FramePacerEnd(FramePacer *pacer)
+{
+    // The time since the last frame belongs to how that frame ended: blocked
+    // on input (plus handling whatever woke it) or paced for animation
+    uint64_t wall = TimerNowNs();
+    uint64_t cpu = ProcessCpuNs();
+    int mode = pacer->waiting ? 0 : 1;
+    pacer->wallNs[mode] += wall - pacer->lastWallNs;
+    pacer->cpuNs[mode] += cpu - pacer->lastCpuNs;
+    pacer->frames[mode]++;
+    pacer->lastWallNs = wall;
+    pacer->lastCpuNs = cpu;
+
+    pacer->waiting = !pacer->animate;
+    pacer->animate = false;
+    return pacer->waiting;
+}
+
+double FramePacerCpuPercent(const FramePacer *pacer, bool animating)
+{
+    int mode = animating ? 1 : 0;
+    if (pacer->wallNs[mode] == 0) return 0.0;
+    return (double)pacer->cpuNs[mode] * 100.0 / (double)pacer->wallNs[mode];
+}
+
+void FramePacerReport(const FramePacer *pacer)
+{
+    printf("Animated: %lld frames over %.1f s, %.2f%% CPU\n",
+           pacer->frames[1], (double)pacer->wallNs[1] / 1e9, FramePacerCpuPercent(pacer, true));
+    printf("Idle: %lld frames over %.1f s, %.2f%% CPU (target %.1f%%)%s\n",
+           pacer->frames[0], (double)pacer->wallNs[0] / 1e9, FramePacerCpuPercent(pacer, false),
+           FRAME_IDLE_CPU_TARGET, FramePacerCpuPercent(pacer, false) > FRAME_IDLE_CPU_TARGET ? " - over target!" : "");
+}
@@ -0,0 +1,40 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame pacing for the window. A frame is only drawn when something calls
+// for one: input, an animation that is still running (the title grid, a
+// vibrating button) or a move the AI has yet to make. Otherwise the main
+// loop blocks on the window's event queue, so sitting on a board costs no
+// CPU. The pacer also measures what both kinds of frame cost, as CPU time
+// per second of wall time, against FRAME_IDLE_CPU_TARGET.
+
+#define FRAME_TARGET_FPS 60         // cap while animating
+#define FRAME_IDLE_CPU_TARGET 1.0   // percent of one core while waiting for input
+
+typedef struct {
+    bool animate;           // something asked for another frame during this one
+    bool waiting;           // the last frame ended blocked on input
+    uint64_t lastWallNs;
+    uint64_t lastCpuNs;
+    uint64_t wallNs[2];     // [0] waiting for input, [1] animating
+    uint64_t cpuNs[2];
+    long long frames[2];
+} FramePacer;
+
+void FramePacerInit(FramePacer *pacer);
+
+// The next frame has to come without waiting for input
+static inline void FrameRequestAnimation(FramePacer *pacer) { pacer->animate = true; }
+
+// Call once per frame, just before it is presented. True means the loop
+// should block on input until the next frame.
+bool FramePacerEnd(FramePacer *pacer);
+
+// Percent of one core used while waiting for input (or while animating)
+double FramePacerCpuPercent(const FramePacer *pacer, bool animating);
+void FramePacerReport(const FramePacer *pacer);
+
+#endif // FRAME_H
@@ -0,0 +1,411 @@
+#include "game_db.h"
+#include "mapped_file.h"
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void SegmentPath(char *path, size_t size, const char *base, int segment)
+{
+    snprintf(path, size, "%s.%d.seg", base, segment);
+}
+
+uint32_t GameMovesEncode(const int *cells, int count)
+{
+    uint32_t rank = 0;
+    unsigned used = 0;
+    for (int i = 0; i < count; i++) {
+        int digit = 0;
+        for (int cell = 0; cell < cells[i]; cell++) digit += !((used >> cell) & 1);
+        rank = rank * (GAME_CELLS - i) + digit;
+        used |= 1u << cells[i];
+    }
+    return (uint32_t)count << 28 | rank;
+}
+
+int GameMovesDecode(uint32_t moves, int cells[GAME_CELLS])
+{
+    int count = (int)(moves >> 28);
+    if (count > GAME_CELLS) return 0;
+
+    // Digits come off the rank last move first
+    int digits[GAME_CELLS];
+    uint32_t rank = moves & 0x0FFFFFFF;
+    for (int i = count - 1; i >= 0; i--) {
+        digits[i] = (int)(rank % (GAME_CELLS - i));
+        rank /= GAME_CELLS - i;
+    }
+
+    unsigned used = 0;
+    for (int i = 0; i < count; i++) {
+        int cell = 0;
+        for (int skip = digits[i]; ; cell++) {
+            if ((used >> cell) & 1) continue;
+            if (skip-- == 0) break;
+        }
+        cells[i] = cell;
+        used |= 1u << cell;
+    }
+    return count;
+}
+
+GameRecord GameRecordFromBoard(const Board *board, int mode, uint32_t seconds, uint32_t playedAt)
+{
+    int cells[GAME_CELLS];
+    int count = board->ply < GAME_CELLS ? board->ply : GAME_CELLS;
+    for (int i = 0; i < count; i++) cells[i] = board->moves[i] & ~BOARD_MOVE_O;
+
+    GameRecord record;
+    record.moves = GameMovesEncode(cells, count);
+    record.outcome = BoardHasLine(board, PLAYER_X) ? GAME_X_WON : BoardHasLine(board, PLAYER_O) ? GAME_O_WON : GAME_DRAWN;
+    record.mode = (uint8_t)mode;
+    record.seconds = (uint16_t)(seconds < 65535 ? seconds : 65535);
+    record.playedAt = playedAt;
+    return record;
+}
+
+int GameRecordOpening(const GameRecord *record)
+{
+    // The first move is the rank's leading digit, and with no cell taken yet it is the cell itself
+    int count = (int)(record->moves >> 28);
+    if (count == 0 || count > GAME_CELLS) return GAME_CELLS;
+    uint32_t rank = record->moves & 0x0FFFFFFF;
+    for (int i = count - 1; i > 0; i--) rank /= GAME_CELLS - i;
+    return (int)rank;
+}
+
+int GameRecordKey(const GameRecord *record)
+{
+    return ((record->mode & GAME_MODE_MASK) * GAME_OUTCOMES + record->outcome % GAME_OUTCOMES) * GAME_OPENINGS +
+           GameRecordOpening(record);
+}
+
+static bool StartSegment(GameDb *db)
+{
+    char path[GAME_MAX_PATH + 16];
+    SegmentPath(path, sizeof(path), db->base, db->segment);
+    db->file = fopen(path, "w+b");
+    db->count = 0;
+
+    GameSegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TTTG", 4);
+    header.version = GAME_DB_VERSION;
+    return db->file != NULL && fwrite(&header, sizeof(header), 1, db->file) == 1;
+}
+
+// Appends the index to a full segment and marks it sealed
+static bool SealSegment(GameDb *db)
+{
+    char path[GAME_MAX_PATH + 16];
+    SegmentPath(path, sizeof(path), db->base, db->segment);
+
+    // Record numbers grouped by key, with a counting sort over the mapped records
+    uint32_t offsets[GAME_INDEX_KEYS + 1] = {0};
+    uint32_t next[GAME_INDEX_KEYS];
+    uint32_t *ids = malloc(db->count * sizeof(uint32_t));
+    MappedFile map;
+    bool ok = ids != NULL && fflush(db->file) == 0 && MappedFileOpen(&map, path);
+    if (ok) {
+        const GameRecord *records = (const GameRecord *)((const char *)map.data + sizeof(GameSegmentHeader));
+        for (uint32_t i = 0; i < db->count; i++) offsets[GameRecordKey(&records[i]) + 1]++;
+        for (int key = 0; key < GAME_INDEX_KEYS; key++) offsets[key + 1] += offsets[key];
+        memcpy(next, offsets, sizeof(next));
+        for (uint32_t i = 0; i < db->count; i++) ids[next[GameRecordKey(&records[i])]++] = i;
+        MappedFileClose(&map);
+    }
+
+    GameSegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TTTG", 4);
+    header.version = GAME_DB_VERSION;
+    header.recordCount = db->count;
+    header.sealed = 1;
+    header.indexOffset = sizeof(header) + (uint64_t)db->count * sizeof(GameRecord);
+
+    ok = ok && fseek(db->file, (long)header.indexOffset, SEEK_SET) == 0 &&
+         fwrite(offsets, sizeof(offsets), 1, db->file) == 1 &&
+         fwrite(ids, sizeof(uint32_t), db->count, db->file) == db->count &&
+         fseek(db->file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, db->file) == 1;
+    ok = fclose(db->file) == 0 && ok;
+    db->file = NULL;
+    free(ids);
+    return ok;
+}
+
+bool GameDbOpen(GameDb *db, const char *base)
+{
+    memset(db, 0, sizeof(*db));
+    snprintf(db->base, sizeof(db->base), "%s", base);
+
+    char path[GAME_MAX_PATH + 16];
+    for (;;) {
+        SegmentPath(path, sizeof(path), base, db->segment + 1);
+        FILE *probe = fopen(path, "rb");
+        if (probe == NULL) break;
+        fclose(probe);
+        db->segment++;
+    }
+
+    // Carry on with the last segment unless it is sealed. A record torn by
+    // a crash is written over.
+    SegmentPath(path, sizeof(path), base, db->segment);
+    GameSegmentHeader header;
+    FILE *file = fopen(path, "r+b");
+    if (file != NULL && fread(&header, sizeof(header), 1, file) == 1) {
+        if (memcmp(header.magic, "TTTG", 4) != 0 || header.version != GAME_DB_VERSION) {
+            printf("Error: %s is not a game segment!\n", path);
+            fclose(file);
+            return false;
+        }
+        if (header.sealed) {
+            fclose(file);
+            db->segment++;
+        } else {
+            fseek(file, 0, SEEK_END);
+            long size = ftell(file);
+            db->count = (uint32_t)((size - (long)sizeof(header)) / (long)sizeof(GameRecord));
+            db->file = file;
+            if (db->count < GAME_SEGMENT_RECORDS) {
+                fseek(file, (long)(sizeof(header) + db->count * sizeof(GameRecord)), SEEK_SET);
+                return true;
+            }
+
+            // Sealing was cut short after the index went in, so it is done again
+            db->count = GAME_SEGMENT_RECORDS;
+            SealSegment(db);
+            db->segment++;
+        }
+    } else if (file != NULL) {
+        fclose(file);
+    }
+
+    if (!StartSegment(db)) {
+        printf("Error creating %s!\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool GameDbAppend(GameDb *db, const GameRecord *record)
+{
+    if (db->file == NULL || fwrite(record, sizeof(*record), 1, db->file) != 1) return false;
+    if (++db->count < GAME_SEGMENT_RECORDS) return true;
+
+    bool ok = SealSegment(db);
+    db->segment++;
+    return StartSegment(db) && ok;
+}
+
+void GameDbClose(GameDb *db)
+{
+    if (db->file != NULL) fclose(db->file);
+    db->file = NULL;
+}
+
+static bool KeyMatches(const GameQuery *query, int key)
+{
+    int opening = key % GAME_OPENINGS;
+    int outcome = key / GAME_OPENINGS % GAME_OUTCOMES;
+    int mode = key / (GAME_OPENINGS * GAME_OUTCOMES);
+    return (query->mode < 0 || query->mode == mode) && (query->outcome < 0 || query->outcome == outcome) &&
+           (query->opening < 0 || query->opening == opening);
+}
+
+// The offsets of a sealed segment's index, or NULL when the index does not
+// fit the file or does not add up to its records, so the segment is scanned
+static const uint32_t *IndexOffsets(const MappedFile *map, const GameSegmentHeader *header)
+{
+    uint64_t recordsEnd = sizeof(*header) + (uint64_t)header->recordCount * sizeof(GameRecord);
+    uint64_t idsStart = header->indexOffset + (GAME_INDEX_KEYS + 1) * sizeof(uint32_t);
+    if (header->recordCount > GAME_SEGMENT_RECORDS || header->indexOffset < recordsEnd || idsStart > map->size) {
+        return NULL;
+    }
+
+    const uint32_t *offsets = (const uint32_t *)((const char *)map->data + header->indexOffset);
+    if (offsets[0] != 0 || offsets[GAME_INDEX_KEYS] != header->recordCount ||
+        idsStart + (uint64_t)header->recordCount * sizeof(uint32_t) > map->size) {
+        return NULL;
+    }
+    for (int key = 0; key < GAME_INDEX_KEYS; key++) {
+        if (offsets[key] > offsets[key + 1]) return NULL;
+    }
+    return offsets;
+}
+
+// True when every record number in the buckets the query asks for is a record
+static bool IdsValid(const GameQuery *query, const uint32_t *offsets, uint32_t recordCount)
+{
+    const uint32_t *ids = offsets + GAME_INDEX_KEYS + 1;
+    for (int key = 0; key < GAME_INDEX_KEYS; key++) {
+        if (!KeyMatches(query, key)) continue;
+        for (uint32_t i = offsets[key]; i < offsets[key + 1]; i++) {
+            if (ids[i] >= recordCount) return false;
+        }
+    }
+    return true;
+}
+
+long long GameDbQuery(const char *base, const GameQuery *query, GameVisitor visit, void *context)
+{
+    long long matched = 0;
+    char path[GAME_MAX_PATH + 16];
+    for (int segment = 0; ; segment++) {
+        SegmentPath(path, sizeof(path), base, segment);
+        MappedFile map;
+        if (!MappedFileOpen(&map, path)) break;
+
+        const GameSegmentHeader *header = map.data;
+        const GameRecord *records = (const GameRecord *)(header + 1);
+        bool valid = map.size >= sizeof(*header) && memcmp(header->magic, "TTTG", 4) == 0 &&
+                     header->version == GAME_DB_VERSION;
+
+        const uint32_t *offsets = valid && header->sealed ? IndexOffsets(&map, header) : NULL;
+        if (offsets != NULL && visit != NULL && !IdsValid(query, offsets, header->recordCount)) offsets = NULL;
+
+        if (offsets != NULL) {
+            // Only the buckets the query asks for
+            const uint32_t *ids = offsets + GAME_INDEX_KEYS + 1;
+            for (int key = 0; key < GAME_INDEX_KEYS; key++) {
+                if (!KeyMatches(query, key)) continue;
+                matched += offsets[key + 1] - offsets[key];
+                if (visit == NULL) continue;
+                for (uint32_t i = offsets[key]; i < offsets[key + 1]; i++) visit(&records[ids[i]], context);
+            }
+        } else if (valid) {
+            // A sealed segment whose index is damaged still has its records up front
+            size_t count = (map.size - sizeof(*header)) / sizeof(GameRecord);
+            if (header->sealed && header->recordCount < count) count = header->recordCount;
+            if (count > GAME_SEGMENT_RECORDS) count = GAME_SEGMENT_RECORDS;
+            for (size_t i = 0; i < count; i++) {
+                if (!KeyMatches(query, GameRecordKey(&records[i]))) continue;
+                matched++;
+                if (visit != NULL) visit(&records[i], context);
+            }
+        }
+        MappedFileClose(&map);
+    }
+    return matched;
+}
+
+// Report: the AI's results at each difficulty, and the games it loses
+
+typedef struct {
+    long long won;
+    long long lost;
+    long long lossesByOpening[GAME_OPENINGS];
+    uint32_t *losses;       // move sequences of the lost games
+    size_t lossCount;
+    size_t lossCapacity;
+} LossReport;
+
+static void CountDecisive(const GameRecord *record, void *context)
+{
+    LossReport *report = context;
+    bool aiWon = (record->outcome == GAME_X_WON) == ((record->mode & GAME_AI_X) != 0);
+    if (aiWon) {
+        report->won++;
+        return;
+    }
+
+    report->lost++;
+    report->lossesByOpening[GameRecordOpening(record)]++;
+    if (report->lossCount == report->lossCapacity) {
+        size_t capacity = report->lossCapacity ? report->lossCapacity * 2 : 1024;
+        uint32_t *grown = realloc(report->losses, capacity * sizeof(uint32_t));
+        if (grown == NULL) return;
+        report->losses = grown;
+        report->lossCapacity = capacity;
+    }
+    report->losses[report->lossCount++] = record->moves;
+}
+
+static int CompareMoves(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void PrintMoves(uint32_t moves)
+{
+    int cells[GAME_CELLS];
+    int count = GameMovesDecode(moves, cells);
+    for (int i = 0; i < count; i++) printf(" %c%d", 'a' + cells[i] % 3, cells[i] / 3 + 1);
+}
+
+static void PrintLosses(LossReport *report)
+{
+    if (report->lost == 0) return;
+    printf("  Losses by opening:");
+    for (int opening = 0; opening < GAME_CELLS; opening++) {
+        if (report->lossesByOpening[opening] == 0) continue;
+        printf(" %c%d %lld", 'a' + opening % 3, opening / 3 + 1, report->lossesByOpening[opening]);
+    }
+    printf("\n");
+
+    // Identical games sit together once sorted; show the three most common
+    qsort(report->losses, report->lossCount, sizeof(uint32_t), CompareMoves);
+    uint32_t top[3] = {0};
+    size_t topCount[3] = {0};
+    for (size_t i = 0, run; i < report->lossCount; i += run) {
+        for (run = 1; i + run < report->lossCount && report->losses[i + run] == report->losses[i]; run++) {}
+        for (int slot = 0; slot < 3; slot++) {
+            if (run <= topCount[slot]) continue;
+            memmove(&top[slot + 1], &top[slot], (2 - slot) * sizeof(top[0]));
+            memmove(&topCount[slot + 1], &topCount[slot], (2 - slot) * sizeof(topCount[0]));
+            top[slot] = report->losses[i];
+            topCount[slot] = run;
+            break;
+        }
+    }
+    for (int slot = 0; slot < 3 && topCount[slot] > 0; slot++) {
+        printf("  Lost %zu times:", topCount[slot]);
+        PrintMoves(top[slot]);
+        printf("\n");
+    }
+}
+
+int GameDbMain(int argc, char **argv)
+{
+    const char *base = argc > 0 ? argv[0] : GAME_DB_DEFAULT_FILE;
+    static const char *modeNames[GAME_MODES] = { "Easy", "Medium", "Hard", "Two players" };
+
+    uint64_t start = TimerNowNs();
+    GameQuery all = { -1, -1, -1 };
+    long long total = GameDbQuery(base, &all, NULL, NULL);
+    if (total == 0) {
+        printf("No games recorded in %s yet\n", base);
+        return 0;
+    }
+
+    for (int mode = 0; mode < GAME_MODES; mode++) {
+        GameQuery drawn = { mode, GAME_DRAWN, -1 };
+        long long draws = GameDbQuery(base, &drawn, NULL, NULL);
+
+        if (mode == GAME_TWO_PLAYER) {
+            GameQuery xWon = { mode, GAME_X_WON, -1 };
+            GameQuery oWon = { mode, GAME_O_WON, -1 };
+            long long xWins = GameDbQuery(base, &xWon, NULL, NULL);
+            long long oWins = GameDbQuery(base, &oWon, NULL, NULL);
+            if (xWins + oWins + draws == 0) continue;
+            printf("%s: %lld games, X won %lld, O won %lld, drawn %lld\n", modeNames[mode], xWins + oWins + draws, xWins, oWins, draws);
+            continue;
+        }
+
+        // Only the decisive games are read
+        LossReport report;
+        memset(&report, 0, sizeof(report));
+        GameQuery xWon = { mode, GAME_X_WON, -1 };
+        GameQuery oWon = { mode, GAME_O_WON, -1 };
+        GameDbQuery(base, &xWon, CountDecisive, &report);
+        GameDbQuery(base, &oWon, CountDecisive, &report);
+        if (report.won + report.lost + draws > 0) {
+            printf("%s: %lld games, AI won %lld, lost %lld, drew %lld\n", modeNames[mode],
+                   report.won + report.lost + draws, report.won, report.lost, draws);
+            PrintLosses(&report);
+        }
+        free(report.losses);
+    }
+
+    printf("%lld games queried in %.3fs\n", total, (TimerNowNs() - start) / 1e9);
+    return 0;
+}
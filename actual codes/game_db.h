@@ -0,0 +1,89 @@
+#ifndef GAME_DB_H
+#define GAME_DB_H
+
+#include "board.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Played games on the classic 3x3 board, kept for analysis. A game's moves
+// are ranked as a partial permutation of the nine cells, so the whole move
+// sequence and its length fit in 32 bits, and a record with the outcome,
+// who played and how long it took is 12 bytes. Records are appended to
+// segment files of up to GAME_SEGMENT_RECORDS games. A full segment is
+// sealed with an index listing its records by mode, outcome and opening
+// move, so a query maps each segment and reads only the records it asks
+// for; only the segment still being written is scanned.
+
+#define GAME_CELLS 9
+#define GAME_DB_DEFAULT_FILE "games"     // segments are games.0.seg, games.1.seg, ...
+#define GAME_DB_VERSION 1
+#define GAME_SEGMENT_RECORDS (1 << 20)
+#define GAME_MAX_PATH 256
+
+typedef enum { GAME_X_WON, GAME_O_WON, GAME_DRAWN, GAME_OUTCOMES } GameOutcome;
+
+// The mode byte holds the Difficulty, or GAME_TWO_PLAYER, and flags
+#define GAME_TWO_PLAYER 3
+#define GAME_MODE_MASK 3
+#define GAME_MODES 4
+#define GAME_MCTS 4             // the AI played with MCTS
+#define GAME_AI_X 8             // the AI had X
+
+#define GAME_OPENINGS (GAME_CELLS + 1)  // the first move, or GAME_CELLS for none
+#define GAME_INDEX_KEYS (GAME_MODES * GAME_OUTCOMES * GAME_OPENINGS)
+
+typedef struct {
+    uint32_t moves;         // see GameMovesEncode
+    uint8_t outcome;
+    uint8_t mode;
+    uint16_t seconds;       // how long the game took, capped at 65535
+    uint32_t playedAt;      // Unix time it ended
+} GameRecord;
+
+typedef struct {
+    char magic[4];          // "TTTG"
+    uint32_t version;
+    uint32_t recordCount;   // once sealed; until then the file size tells
+    uint32_t sealed;
+    // Once sealed: GAME_INDEX_KEYS + 1 offsets into the record numbers
+    // that follow them, which are grouped by GameRecordKey
+    uint64_t indexOffset;
+} GameSegmentHeader;
+
+typedef struct {
+    int mode;               // mode & GAME_MODE_MASK, -1 for any
+    int outcome;            // -1 for any
+    int opening;            // -1 for any
+} GameQuery;
+
+typedef struct {
+    char base[GAME_MAX_PATH];
+    FILE *file;             // the segment being written
+    int segment;
+    uint32_t count;
+} GameDb;
+
+// Move count in the top 4 bits, and below it the moves in mixed radix:
+// each move is its position among the cells still free
+uint32_t GameMovesEncode(const int *cells, int count);
+int GameMovesDecode(uint32_t moves, int cells[GAME_CELLS]);
+
+// The record of a finished game on a classic board, from its move stack
+GameRecord GameRecordFromBoard(const Board *board, int mode, uint32_t seconds, uint32_t playedAt);
+int GameRecordOpening(const GameRecord *record);
+int GameRecordKey(const GameRecord *record);
+
+// Appends to the last segment of base, starting a new one once it is sealed
+bool GameDbOpen(GameDb *db, const char *base);
+bool GameDbAppend(GameDb *db, const GameRecord *record);
+void GameDbClose(GameDb *db);
+
+// Calls visit for every record matching the query, returns how many did
+typedef void (*GameVisitor)(const GameRecord *record, void *context);
+long long GameDbQuery(const char *base, const GameQuery *query, GameVisitor visit, void *context);
+
+// Entry point for "--games [file]": where each difficulty loses
+int GameDbMain(int argc, char **argv);
+
+#endif // GAME_DB_H
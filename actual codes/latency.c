@@ -0,0 +1,49 @@
+#include "latency.h"
+
+static int BucketIndex(uint64_t ns)
+{
+    if (ns < LATENCY_SUB_BUCKETS) return (int)ns;
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (exponent - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return (exponent - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Smallest value that lands in the bucket
+static uint64_t BucketFloor(int index)
+{
+    if (index < LATENCY_SUB_BUCKETS) return (uint64_t)index;
+    int exponent = index / LATENCY_SUB_BUCKETS + LATENCY_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(index % LATENCY_SUB_BUCKETS);
+    return ((uint64_t)LATENCY_SUB_BUCKETS + sub) << (exponent - LATENCY_SUB_BITS);
+}
+
+void LatencyRecord(LatencyHistogram *histogram, uint64_t ns)
+{
+    histogram->buckets[BucketIndex(ns)]++;
+    histogram->count++;
+    histogram->totalNs += ns;
+    if (ns > histogram->maxNs) histogram->maxNs = ns;
+}
+
+void LatencyMerge(LatencyHistogram *into, const LatencyHistogram *from)
+{
+    for (int i = 0; i < LATENCY_BUCKETS; i++) into->buckets[i] += from->buckets[i];
+    into->count += from->count;
+    into->totalNs += from->totalNs;
+    if (from->maxNs > into->maxNs) into->maxNs = from->maxNs;
+}
+
+uint64_t LatencyPercentile(const LatencyHistogram *histogram, double percentile)
+{
+    if (histogram->count == 0) return 0;
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)histogram->count);
+    if (target >= histogram->count) target = histogram->count - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > target) return BucketFloor(i);
+    }
+    return histogram->maxNs;
+}
@@ -0,0 +1,24 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+// Log-linear latency histogram: every power of two is split into
+// LATENCY_SUB_BUCKETS linear steps, so percentiles stay within ~12%.
+
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+} LatencyHistogram;
+
+void LatencyRecord(LatencyHistogram *histogram, uint64_t ns);
+void LatencyMerge(LatencyHistogram *into, const LatencyHistogram *from);
+uint64_t LatencyPercentile(const LatencyHistogram *histogram, double percentile);
+
+#endif // LATENCY_H
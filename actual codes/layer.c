@@ -0,0 +1,52 @@
+#include "layer.h"
+#include "profiler.h"
+
+bool LayerBegin(Layer *layer, int width, int height, unsigned version)
+{
+    if (layer->ready && layer->version == version &&
+        layer->target.texture.width == width && layer->target.texture.height == height) {
+        return false;
+    }
+
+    if (layer->target.id == 0 || layer->target.texture.width != width || layer->target.texture.height != height) {
+        if (layer->target.id != 0) UnloadRenderTexture(layer->target);
+        layer->target = LoadRenderTexture(width, height);
+    }
+    layer->version = version;
+    layer->ready = true;
+
+    BeginTextureMode(layer->target);
+    return true;
+}
+
+void LayerEnd(Layer *layer)
+{
+    (void)layer;
+    EndTextureMode();
+}
+
+void LayerDraw(const Layer *layer, Vector2 position)
+{
+    Rectangle all = { 0, 0, (float)layer->target.texture.width, (float)layer->target.texture.height };
+    LayerDrawRegion(layer, all, position);
+}
+
+void LayerDrawRegion(const Layer *layer, Rectangle region, Vector2 position)
+{
+    // Render textures are stored bottom-up, hence the flipped source
+    Rectangle source = {
+        region.x,
+        layer->target.texture.height - region.y - region.height,
+        region.width,
+        -region.height
+    };
+    DrawTextureRec(layer->target.texture, source, position, WHITE);
+    ProfilerCountDraws(1);
+}
+
+void LayerUnload(Layer *layer)
+{
+    if (layer->target.id != 0) UnloadRenderTexture(layer->target);
+    layer->target = (RenderTexture2D){0};
+    layer->ready = false;
+}
@@ -0,0 +1,31 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Cached drawing layers: static content (the board, titles, instruction
+// text, the analysis page) is drawn once into a render texture and then
+// blitted every frame. Each layer remembers the version of the content it
+// holds, and callers bump their version when that content changes, so a
+// layer is only redrawn on the first frame after a change.
+
+typedef struct {
+    RenderTexture2D target;
+    unsigned version;   // of the content last drawn into it
+    bool ready;
+} Layer;
+
+// True when the layer has to be redrawn for this version. Draw it between
+// this call and LayerEnd, in the layer's own coordinates.
+bool LayerBegin(Layer *layer, int width, int height, unsigned version);
+void LayerEnd(Layer *layer);
+
+void LayerDraw(const Layer *layer, Vector2 position);
+
+// Draws part of the layer, given in the layer's coordinates
+void LayerDrawRegion(const Layer *layer, Rectangle region, Vector2 position);
+
+void LayerUnload(Layer *layer);
+
+#endif // LAYER_H
@@ -0,0 +1,202 @@
+#include "learner.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    signed char cells[LEARNER_FEATURES];
+    signed char label;          // 1 if X went on to win
+    bool gameEnd;               // the game's last position
+} LabelledPosition;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t learned = PTHREAD_COND_INITIALIZER;
+static pthread_t thread;
+static bool running = false;
+static bool stopping = false;
+static float rate;
+static long long limit;             // games to learn from at most, raised by LearnerTakeAt when paced
+
+// Filled under lock by the game, swapped with the learner's batch
+static LabelledPosition *buffer;
+static LabelledPosition *batch;
+static int bufferCount;
+static long long bufferGames;
+static long long takenGames;        // since LearnerStart, moved out of the buffer
+static long long learnedGames;      // of those, the ones published
+
+// The learner's own weights, and copies of them handed to the game: the
+// newest one published, until the game takes it, and the one it holds
+static LinearModel learning;
+static _Atomic(LinearModel *) fresh;
+static LinearModel *held;
+
+static float Predict(const float weights[LEARNER_FEATURES + 1], const signed char cells[LEARNER_FEATURES])
+{
+    float result = weights[LEARNER_FEATURES];
+    for (int i = 0; i < LEARNER_FEATURES; i++) result += weights[i] * cells[i];
+    return result;
+}
+
+float LinearModelPredict(const LinearModel *model, const Board *board)
+{
+    signed char cells[LEARNER_FEATURES];
+    for (int i = 0; i < LEARNER_FEATURES; i++) {
+        Cell cell = BoardGetCell(board, i);
+        cells[i] = cell == PLAYER_X ? 1 : cell == PLAYER_O ? -1 : 0;
+    }
+    return Predict(model->weights, cells);
+}
+
+// Hands a copy of the learner's weights to the game. A copy the game never
+// took is freed, as nothing else can reach it.
+static void Publish(void)
+{
+    LinearModel *next = malloc(sizeof(LinearModel));
+    if (next == NULL) return;
+    *next = learning;
+    free(atomic_exchange_explicit(&fresh, next, memory_order_acq_rel));
+}
+
+static void *LearnerMain(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        // Games queued before LearnerStop are still learned from, past the limit too
+        while ((bufferGames == 0 || takenGames >= limit) && !stopping) pthread_cond_wait(&wake, &lock);
+        if (bufferGames == 0) break;
+
+        long long games = stopping || bufferGames <= limit - takenGames ? bufferGames : limit - takenGames;
+        LabelledPosition *positions = batch;
+        int count = 0;
+        if (games == bufferGames) {
+            // All of it, so the buffers swap
+            positions = buffer;
+            count = bufferCount;
+            buffer = batch;
+            batch = positions;
+            bufferCount = 0;
+        } else {
+            // The games up to the limit, and the rest moves up
+            for (long long ended = 0; ended < games; count++) ended += buffer[count].gameEnd;
+            memcpy(positions, buffer, count * sizeof(LabelledPosition));
+            memmove(buffer, buffer + count, (bufferCount - count) * sizeof(LabelledPosition));
+            bufferCount -= count;
+        }
+        bufferGames -= games;
+        takenGames += games;
+        pthread_mutex_unlock(&lock);
+
+        float *weights = learning.weights;
+        for (int i = 0; i < count; i++) {
+            float error = positions[i].label - Predict(weights, positions[i].cells);
+            for (int j = 0; j < LEARNER_FEATURES; j++) weights[j] += rate * error * positions[i].cells[j];
+            weights[LEARNER_FEATURES] += rate * error;
+        }
+        learning.positions += count;
+        learning.games += games;
+        Publish();
+
+        pthread_mutex_lock(&lock);
+        learnedGames += games;
+        pthread_cond_broadcast(&learned);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+bool LearnerStart(const float weights[LEARNER_FEATURES + 1], float learningRate, bool paced)
+{
+    LearnerStop();
+    memset(&learning, 0, sizeof(learning));
+    memcpy(learning.weights, weights, sizeof(learning.weights));
+
+    buffer = malloc(LEARNER_MAX_BUFFERED * sizeof(LabelledPosition));
+    batch = malloc(LEARNER_MAX_BUFFERED * sizeof(LabelledPosition));
+    Publish();
+    if (buffer == NULL || batch == NULL || atomic_load(&fresh) == NULL) {
+        LearnerStop();
+        return false;
+    }
+
+    rate = learningRate;
+    bufferCount = 0;
+    bufferGames = 0;
+    takenGames = 0;
+    learnedGames = 0;
+    limit = paced ? 0 : LLONG_MAX;
+    stopping = false;
+    running = pthread_create(&thread, NULL, LearnerMain, NULL) == 0;
+    if (!running) LearnerStop();
+    return running;
+}
+
+void LearnerAddGame(const Board *board)
+{
+    if (!running || board->geo->cellCount != LEARNER_FEATURES || board->ply == 0) return;
+    signed char label = BoardHasLine(board, PLAYER_X) ? 1 : 0;
+
+    pthread_mutex_lock(&lock);
+    if (bufferCount + board->ply <= LEARNER_MAX_BUFFERED) {
+        // Every position from the first move to the last, replayed from the move stack
+        signed char cells[LEARNER_FEATURES] = {0};
+        for (int i = 0; i < board->ply; i++) {
+            int move = board->moves[i];
+            cells[move & ~BOARD_MOVE_O] = (move & BOARD_MOVE_O) ? -1 : 1;
+            LabelledPosition *position = &buffer[bufferCount++];
+            memcpy(position->cells, cells, sizeof(cells));
+            position->label = label;
+            position->gameEnd = i == board->ply - 1;
+        }
+        bufferGames++;
+        pthread_cond_signal(&wake);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+const LinearModel *LearnerTake(void)
+{
+    // Only the game takes models, so the one it held before is free to go
+    LinearModel *newer = atomic_exchange_explicit(&fresh, NULL, memory_order_acq_rel);
+    if (newer != NULL) {
+        free(held);
+        held = newer;
+    }
+    return held;
+}
+
+const LinearModel *LearnerTakeAt(long long games)
+{
+    if (!running) return LearnerTake();
+    pthread_mutex_lock(&lock);
+    if (games > limit) {
+        limit = games;
+        pthread_cond_signal(&wake);
+    }
+    while (learnedGames < games && takenGames + bufferGames >= games) pthread_cond_wait(&learned, &lock);
+    pthread_mutex_unlock(&lock);
+    return LearnerTake();
+}
+
+void LearnerStop(void)
+{
+    if (running) {
+        pthread_mutex_lock(&lock);
+        stopping = true;
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&lock);
+        pthread_join(thread, NULL);
+        running = false;
+    }
+
+    free(atomic_exchange(&fresh, NULL));
+    free(held);
+    held = NULL;
+    free(buffer);
+    free(batch);
+    buffer = batch = NULL;
+}
@@ -0,0 +1,50 @@
+#ifndef LEARNER_H
+#define LEARNER_H
+
+#include "board.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Online learning for the linear model trained at startup. Each finished
+// game adds every position it went through, labelled with how it ended, to
+// an in-memory buffer. A learner thread takes whatever has built up, applies
+// one LMS update per position to its weights and publishes a copy with an
+// atomic pointer swap, so play never waits for training. The AI takes up
+// the newest model when a game starts and keeps it for the whole game. How
+// many games that model had learned from depends on thread timing, so a
+// recording keeps the count, and a replay runs the learner paced: it learns
+// no further than the count of the game being replayed, and waits for it.
+// Only two copies live at a time: the one the game holds and the newest one
+// published, which replaces any it had not taken.
+
+#define LEARNER_FEATURES 9          // the classic board's cells, X = 1, O = -1
+#define LEARNER_MAX_BUFFERED 65536  // positions waiting; more are dropped until the learner catches up
+
+typedef struct {
+    float weights[LEARNER_FEATURES + 1];    // the last one is the bias
+    long long positions;                    // learned from since startup
+    long long games;
+} LinearModel;
+
+// Starts from the trained weights. A paced learner only learns as far as
+// LearnerTakeAt asks.
+bool LearnerStart(const float weights[LEARNER_FEATURES + 1], float learningRate, bool paced);
+
+// Queues the positions of a finished game on a classic board; never blocks on training
+void LearnerAddGame(const Board *board);
+
+// The newest model, without waiting; NULL before LearnerStart. It stays
+// valid until the next LearnerTake or LearnerTakeAt, or LearnerStop, and
+// only the game's thread may take models.
+const LinearModel *LearnerTake(void);
+
+// For a paced learner: waits for the model learned from the first `games`
+// games queued, and takes it
+const LinearModel *LearnerTakeAt(long long games);
+
+// Estimated chance that X wins from the position
+float LinearModelPredict(const LinearModel *model, const Board *board);
+
+void LearnerStop(void);
+
+#endif // LEARNER_H
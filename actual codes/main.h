@@ -2,6 +2,23 @@
 #define MAIN_H
 
 #include "raylib.h"
+#include "board.h"
+#include "engine.h"
+#include "arena.h"
+#include "pns.h"
+#include "batch.h"
+#include "protocol.h"
+#include "server.h"
+#include "frame.h"
+#include "layer.h"
+#include "text_layout.h"
+#include "widget.h"
+#include "profiler.h"
+#include "trace.h"
+#include "replay.h"
+#include "stats_store.h"
+#include "game_db.h"
+#include "platform.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -18,18 +35,20 @@
 #define CELL_SIZE (SCREEN_WIDTH / GRID_SIZE)
 #define FEATURES 9 // Number of features (board positions)
 #define TITLE_GRID_SIZE 3
+#define ENDGAME_MAX_EMPTY 6 // Tablebase covers positions with this many empty cells or fewer
+#define SOLVER_ITERATIONS 100000 // Proof-number budget per position for exact verdicts
+#define ANALYSIS_CONTENT_HEIGHT 1030 // Total height of the AI Analysis page
+#define PROFILER_OVERLAY_FRAMES 240 // frames summarised by the F3 overlay
 
-typedef enum { EMPTY, PLAYER_X, PLAYER_O } Cell;
 typedef enum { PLAYER_X_TURN, PLAYER_O_TURN } PlayerTurn;
 typedef enum { MENU, DIFFICULTY_SELECT, GAME, GAME_OVER, AI_ANALYSIS, HOW_TO_PLAY } GameState;
-typedef enum { EASY, MEDIUM, HARD } Difficulty;
-
-typedef struct {
-    int wins;
-    int losses;
-    int draws;
-    int totalGames;
-} DifficultyStats;
+typedef enum {
+    WIDGET_SINGLE_PLAYER, WIDGET_TWO_PLAYERS, WIDGET_ANALYSIS, WIDGET_HOW_TO_PLAY,
+    WIDGET_EASY, WIDGET_MEDIUM, WIDGET_HARD, WIDGET_ENGINE,
+    WIDGET_QUIT, WIDGET_UNDO, WIDGET_REDO,
+    WIDGET_RETRY, WIDGET_BACK_TO_MENU,
+    WIDGET_BACK // to the menu from the other screens
+} WidgetId;
 
 typedef struct {
     int tp, tn, fp, fn; // True Positives, True Negatives, False Positives, False Negatives
@@ -66,6 +85,23 @@ extern float titleAnimSpeed;
 extern float buttonVibrationOffset;
 extern float vibrationSpeed;
 extern float vibrationAmount;
+extern const BoardGeometry *classicGeometry;
+extern Tablebase endgameTablebase;
+extern EngineType currentEngine;
+extern Engine aiEngine;
+extern Board gameBoard;
+extern PnsSolver positionSolver;
+extern PnsResult openingVerdict;
+extern int turningPoint;
+extern long long analysisNodes;
+extern FramePacer framePacer;
+extern GameDb gameLog;
+extern uint64_t gameStartedAt;
+extern unsigned boardVersion;
+extern unsigned statsVersion;
+extern WidgetTable screenWidgets[HOW_TO_PLAY + 1];
+extern const Widget *hotWidget;
+extern bool showProfiler;
 
 // Declare scroll variables
 static float scrollY = 0.0f;
@@ -73,24 +109,34 @@ static const float scrollSpeed = 20.0f;
 
 void InitGame();
 void UpdateGame();
-void UpdateGameOver();
 void HandlePlayerTurn();
 void AITurn();
+void CountGameResult(StatsResult result);
+void SaveGameRecord(void);
 void DrawGame();
 void DrawDifficultySelect(void);
+void PlaceMark(int row, int col, Cell player);
+void UndoMove();
+void RedoMove();
 bool CheckWin(Cell player);
 bool CheckDraw();
 void DrawMenu();
 void DrawGameOver();
 void LoadAndEvaluateDataset(void);
 void DrawHowToPlay(void);
-
-int Minimax(Cell board[GRID_SIZE][GRID_SIZE], bool isMaximizing, int depth, int depthLimit);
-int EvaluateBoard(Cell board[GRID_SIZE][GRID_SIZE]);
+void LoadEndgameTablebase(void);
+void AnalyzeLastGame(void);
+void UpdateFrame(void);
+int ReplayMain(int argc, char **argv);
+void InitWidgets(void);
+void ActivateWidget(const Widget *widget);
 
 void DrawAIAnalysis();
 void DrawDifficultySection(const char* difficulty, DifficultyStats stats, int* y, Color color, int padding, int textFontSize);
-void DrawButton(Rectangle bounds, const char* text, int fontSize, bool isHovered);
+void DrawProfilerOverlay(void);
+void DrawWidgets(const WidgetTable *table);
+const char *WidgetLabel(const Widget *widget);
+void DrawButton(const Widget *widget, bool isHovered);
 
 // Linear Regression Functions
 void TrainLinearRegression(float weights[FEATURES + 1], float learningRate, int epochs);
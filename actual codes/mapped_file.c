@@ -0,0 +1,78 @@
+#include "mapped_file.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+bool MappedFileOpen(MappedFile *file, const char *path)
+{
+    memset(file, 0, sizeof(*file));
+
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fileHandle); // the mapping keeps the file open
+    if (mapping == NULL) return false;
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file->data = data;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+    return true;
+}
+
+void MappedFileClose(MappedFile *file)
+{
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->handle != NULL) CloseHandle((HANDLE)file->handle);
+    memset(file, 0, sizeof(*file));
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFileOpen(MappedFile *file, const char *path)
+{
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFileClose(MappedFile *file)
+{
+    if (file->data != NULL) munmap((void *)file->data, file->size);
+    memset(file, 0, sizeof(*file));
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, file mappings on Windows)
+typedef struct {
+    const void *data;
+    size_t size;
+    void *handle;  // platform mapping handle, NULL on POSIX
+} MappedFile;
+
+bool MappedFileOpen(MappedFile *file, const char *path);
+void MappedFileClose(MappedFile *file);
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,266 @@
+#include "mcts.h"
+#include "platform.h"
+#include "rng.h"
+#include <math.h>
+#include <stdlib.h>
+
+static int AllocNode(MctsEngine *engine, int parent, int move)
+{
+    int node;
+    if (engine->freeList != -1) {
+        node = engine->freeList;
+        engine->freeList = engine->nodes[node].nextSibling;
+    } else if (engine->used < engine->capacity) {
+        node = engine->used++;
+    } else {
+        return -1; // pool exhausted, the search keeps going without growing the tree
+    }
+
+    MctsNode *n = &engine->nodes[node];
+    memset(n, 0, sizeof(*n));
+    n->move = move;
+    n->parent = parent;
+    n->firstChild = -1;
+    n->nextSibling = -1;
+    n->winner = EMPTY;
+    return node;
+}
+
+static void FreeNode(MctsEngine *engine, int node)
+{
+    engine->nodes[node].nextSibling = engine->freeList;
+    engine->freeList = node;
+}
+
+// Releases every node under `node` except the subtree rooted at `keep`
+static void ReleaseExcept(MctsEngine *engine, int node, int keep)
+{
+    if (node == keep) return;
+
+    int child = engine->nodes[node].firstChild;
+    while (child != -1) {
+        int next = engine->nodes[child].nextSibling; // read before the child is recycled
+        ReleaseExcept(engine, child, keep);
+        child = next;
+    }
+    FreeNode(engine, node);
+}
+
+static void ResetTree(MctsEngine *engine, const Board *board)
+{
+    engine->freeList = -1;
+    engine->used = 0;
+    engine->rootBoard = *board;
+    engine->root = AllocNode(engine, -1, -1);
+}
+
+bool MctsInit(MctsEngine *engine, int capacity, uint64_t seed)
+{
+    memset(engine, 0, sizeof(*engine));
+    engine->nodes = malloc(sizeof(MctsNode) * (size_t)capacity);
+    if (engine->nodes == NULL) return false;
+
+    engine->capacity = capacity;
+    engine->freeList = -1;
+    engine->root = -1;
+    engine->rng = RngSeed(seed);
+    engine->exploration = MCTS_EXPLORATION;
+    return true;
+}
+
+void MctsFree(MctsEngine *engine)
+{
+    free(engine->nodes);
+    memset(engine, 0, sizeof(*engine));
+}
+
+static int FindChild(const MctsEngine *engine, int node, int move)
+{
+    for (int child = engine->nodes[node].firstChild; child != -1; child = engine->nodes[child].nextSibling) {
+        if (engine->nodes[child].move == move) return child;
+    }
+    return -1;
+}
+
+// Returns the cell `player` added between the two boards, or -1 if there is none
+static int AddedCell(const Board *from, const Board *to, Cell player)
+{
+    const Bitboard *before = &from->pieces[SideIndex(player)];
+    const Bitboard *after = &to->pieces[SideIndex(player)];
+
+    for (int i = 0; i < from->geo->words; i++) {
+        uint64_t added = after->w[i] & ~before->w[i];
+        if (added) return i * 64 + __builtin_ctzll(added);
+    }
+    return -1;
+}
+
+void MctsSetPosition(MctsEngine *engine, const Board *board)
+{
+    const Board *rootBoard = &engine->rootBoard;
+    int moves = board->filled - rootBoard->filled;
+    int keep = -1;
+
+    if (engine->root != -1 && rootBoard->geo == board->geo && moves >= 0 && moves <= 2) {
+        bool follows = true;
+        for (int side = 0; side < 2 && follows; side++) {
+            follows = BitboardContains(&board->pieces[side], &rootBoard->pieces[side], board->geo->words);
+        }
+
+        // Walk down the tree along the moves played since the last search
+        Cell player = BoardSideToMove(rootBoard);
+        keep = follows ? engine->root : -1;
+        for (int i = 0; i < moves && keep != -1; i++) {
+            int cell = AddedCell(rootBoard, board, player);
+            keep = (cell == -1) ? -1 : FindChild(engine, keep, cell);
+            player = Opponent(player);
+        }
+    }
+
+    if (keep == -1) {
+        ResetTree(engine, board);
+        return;
+    }
+
+    ReleaseExcept(engine, engine->root, keep);
+    engine->nodes[keep].parent = -1;
+    engine->nodes[keep].nextSibling = -1;
+    engine->root = keep;
+    engine->rootBoard = *board;
+}
+
+static void Expand(MctsEngine *engine, int node, Board *board, Cell player)
+{
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, cells);
+    int *link = &engine->nodes[node].firstChild;
+
+    for (int i = 0; i < count; i++) {
+        int child = AllocNode(engine, node, cells[i]);
+        if (child == -1) {
+            // A node with some of its moves missing would never get the rest, so it
+            // stays a leaf until the pool has room for all of them
+            for (int c = engine->nodes[node].firstChild; c != -1; ) {
+                int next = engine->nodes[c].nextSibling;
+                FreeNode(engine, c);
+                c = next;
+            }
+            engine->nodes[node].firstChild = -1;
+            return;
+        }
+
+        // Terminal children are flagged up front so the search never plays past them
+        MctsNode *c = &engine->nodes[child];
+        BoardMakeMove(board, cells[i], player);
+        if (BoardHasLine(board, player)) {
+            c->terminal = true;
+            c->winner = player;
+        } else if (BoardIsDrawn(board)) {
+            c->terminal = true;
+        }
+        BoardUnmakeMove(board);
+
+        *link = child;
+        link = &c->nextSibling;
+    }
+    engine->nodes[node].expanded = engine->nodes[node].firstChild != -1;
+}
+
+static int SelectChild(const MctsEngine *engine, int node)
+{
+    float logVisits = logf((float)engine->nodes[node].visits + 1.0f);
+    float bestValue = -1.0f;
+    int best = -1;
+
+    for (int child = engine->nodes[node].firstChild; child != -1; child = engine->nodes[child].nextSibling) {
+        const MctsNode *c = &engine->nodes[child];
+        if (c->visits == 0) return child;
+
+        float value = c->wins / c->visits + engine->exploration * sqrtf(logVisits / c->visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = child;
+        }
+    }
+    return best;
+}
+
+// Plays uniformly random moves until someone wins or no line is left open
+static Cell Playout(MctsEngine *engine, Board *board, Cell player)
+{
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, cells);
+
+    while (count > 0 && !BoardIsDrawn(board)) {
+        int pick = RngRange(&engine->rng, count);
+        int cell = cells[pick];
+        cells[pick] = cells[--count];
+
+        BoardMakeMove(board, cell, player);
+        if (BoardHasLine(board, player)) return player;
+        player = Opponent(player);
+    }
+    return EMPTY;
+}
+
+int MctsSearch(MctsEngine *engine, int playouts)
+{
+    if (engine->root == -1) return -1;
+
+    int path[BOARD_MAX_CELLS + 1];
+    for (int iteration = 0; iteration < playouts || iteration == 0; iteration++) {
+        if (iteration > 0 && iteration % MCTS_STOP_CHECK_PLAYOUTS == 0 &&
+            ((engine->stop != NULL && atomic_load_explicit(engine->stop, memory_order_relaxed)) ||
+             (engine->deadline != 0 && TimerNowNs() > engine->deadline))) {
+            break;
+        }
+
+        Board board = engine->rootBoard;
+        Cell player = BoardSideToMove(&board);
+        int node = engine->root;
+        int depth = 0;
+        path[depth++] = node;
+
+        // Selection
+        while (engine->nodes[node].expanded && !engine->nodes[node].terminal) {
+            node = SelectChild(engine, node);
+            BoardMakeMove(&board, engine->nodes[node].move, player);
+            player = Opponent(player);
+            path[depth++] = node;
+        }
+
+        // Expansion, once a leaf has been visited before (the root always expands)
+        MctsNode *leaf = &engine->nodes[node];
+        if (!leaf->terminal && (leaf->visits > 0 || node == engine->root)) {
+            Expand(engine, node, &board, player);
+            if (engine->nodes[node].expanded) {
+                node = SelectChild(engine, node);
+                BoardMakeMove(&board, engine->nodes[node].move, player);
+                player = Opponent(player);
+                path[depth++] = node;
+            }
+        }
+
+        // Simulation
+        Cell winner = engine->nodes[node].terminal ? engine->nodes[node].winner : Playout(engine, &board, player);
+
+        // Backpropagation: each node is scored for the player who moved into it
+        Cell mover = Opponent(BoardSideToMove(&engine->rootBoard));
+        for (int i = 0; i < depth; i++) {
+            MctsNode *n = &engine->nodes[path[i]];
+            n->visits++;
+            if (winner == EMPTY) n->wins += 0.5f;
+            else if (winner == mover) n->wins += 1.0f;
+            mover = Opponent(mover);
+        }
+    }
+
+    int bestMove = -1, bestVisits = -1;
+    for (int child = engine->nodes[engine->root].firstChild; child != -1; child = engine->nodes[child].nextSibling) {
+        if (engine->nodes[child].visits > bestVisits) {
+            bestVisits = engine->nodes[child].visits;
+            bestMove = engine->nodes[child].move;
+        }
+    }
+    return bestMove;
+}
@@ -0,0 +1,55 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "board.h"
+#include <stdatomic.h>
+
+// Monte Carlo Tree Search (UCT) with random bitboard playouts.
+// Nodes live in a fixed pool allocated once; subtrees that are no longer
+// reachable after a move go back onto a free list, so the part of the tree
+// that is still relevant survives from one move to the next.
+//
+// Like the negamax search, a search can be given a deadline and a stop flag
+// another thread may raise; it then returns the most visited move so far.
+
+#define MCTS_DEFAULT_NODES (1 << 18)
+#define MCTS_EXPLORATION 1.41f
+#define MCTS_STOP_CHECK_PLAYOUTS 256  // the clock is read once per this many playouts
+
+typedef struct {
+    int move;         // cell played to reach this node, -1 for the root
+    int parent;
+    int firstChild;
+    int nextSibling;  // also links the free list
+    int visits;
+    float wins;       // scored for the player who made `move`, draws count half
+    bool expanded;
+    bool terminal;
+    Cell winner;      // EMPTY for a drawn terminal node
+} MctsNode;
+
+typedef struct {
+    MctsNode *nodes;
+    int capacity;
+    int freeList;
+    int used;
+    int root;
+    Board rootBoard;
+    uint64_t rng;
+    float exploration;
+    uint64_t deadline;          // TimerNowNs() to stop at, 0 = no time limit
+    const atomic_bool *stop;    // may be NULL
+} MctsEngine;
+
+bool MctsInit(MctsEngine *engine, int capacity, uint64_t seed);
+void MctsFree(MctsEngine *engine);
+
+// Points the engine at a position, keeping the matching subtree when the
+// position follows from the current root by one or two moves
+void MctsSetPosition(MctsEngine *engine, const Board *board);
+
+// Runs the given number of playouts, or fewer if stopped, and returns the
+// most visited move
+int MctsSearch(MctsEngine *engine, int playouts);
+
+#endif // MCTS_H
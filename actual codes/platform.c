@@ -0,0 +1,107 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // sched_setaffinity
+#endif
+#include "platform.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+
+uint64_t TimerNowNs(void)
+{
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)frequency.QuadPart);
+}
+
+uint64_t ProcessCpuNs(void)
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) * 100; // FILETIME counts 100 ns ticks
+}
+
+int CpuCount(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+bool PinThread(int cpu)
+{
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (cpu % (int)(sizeof(DWORD_PTR) * 8))) != 0;
+}
+
+void ThreadYield(void)
+{
+    SwitchToThread();
+}
+
+bool FileSync(FILE *file)
+{
+    return fflush(file) == 0 && _commit(_fileno(file)) == 0;
+}
+
+bool FileReplace(const char *from, const char *to)
+{
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+#else
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t TimerNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t ProcessCpuNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int CpuCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+bool PinThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0; // 0 = the calling thread
+#else
+    return false;
+#endif
+}
+
+void ThreadYield(void)
+{
+    sched_yield();
+}
+
+bool FileSync(FILE *file)
+{
+    return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+bool FileReplace(const char *from, const char *to)
+{
+    return rename(from, to) == 0;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Thin wrappers over the few OS services the engine code needs
+
+uint64_t TimerNowNs(void);  // monotonic clock in nanoseconds
+uint64_t ProcessCpuNs(void); // CPU time used by the whole process, all threads
+int CpuCount(void);
+bool PinThread(int cpu);    // keeps the calling thread on one core
+void ThreadYield(void);
+bool FileSync(FILE *file);  // flushes and waits until the data is on disk
+bool FileReplace(const char *from, const char *to); // rename, replacing `to` if it exists
+
+#endif // PLATFORM_H
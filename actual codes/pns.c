@@ -0,0 +1,333 @@
+#include "pns.h"
+#include <stdlib.h>
+
+#define ATTACKER_O_KEY 0x9e3779b97f4a7c15ull // keeps the answers for both attackers apart
+
+bool PnsInit(PnsSolver *solver, int capacity, int tableBits)
+{
+    memset(solver, 0, sizeof(*solver));
+    solver->nodes = malloc(sizeof(PnsNode) * (size_t)capacity);
+    solver->table = calloc((size_t)1 << tableBits, sizeof(PnsEntry));
+    if (solver->nodes == NULL || solver->table == NULL) {
+        PnsFree(solver);
+        return false;
+    }
+
+    solver->capacity = capacity;
+    solver->mask = ((size_t)1 << tableBits) - 1;
+    solver->freeList = -1;
+    solver->secondLevel = PNS_SECOND_LEVEL;
+    return true;
+}
+
+void PnsFree(PnsSolver *solver)
+{
+    free(solver->nodes);
+    free(solver->table);
+    memset(solver, 0, sizeof(*solver));
+}
+
+static int AllocNode(PnsSolver *solver, int parent, int move, bool isOr, int depth)
+{
+    int node;
+    if (solver->freeList != -1) {
+        node = solver->freeList;
+        solver->freeList = solver->nodes[node].nextSibling;
+    } else if (solver->used < solver->capacity) {
+        node = solver->used++;
+    } else {
+        return -1;
+    }
+
+    PnsNode *n = &solver->nodes[node];
+    memset(n, 0, sizeof(*n));
+    n->proof = 1;
+    n->disproof = 1;
+    n->parent = parent;
+    n->firstChild = -1;
+    n->nextSibling = -1;
+    n->move = (short)move;
+    n->depth = (unsigned char)depth;
+    n->isOr = isOr;
+    n->inUse = true;
+    solver->live++;
+    solver->created++;
+    return node;
+}
+
+static void FreeNode(PnsSolver *solver, int node)
+{
+    solver->nodes[node].inUse = false;
+    solver->nodes[node].nextSibling = solver->freeList;
+    solver->freeList = node;
+    solver->live--;
+}
+
+// Releases everything below the node, which becomes a leaf again
+static void FreeChildren(PnsSolver *solver, int node)
+{
+    int child = solver->nodes[node].firstChild;
+    while (child != -1) {
+        int next = solver->nodes[child].nextSibling; // read before the child is recycled
+        FreeChildren(solver, child);
+        FreeNode(solver, child);
+        child = next;
+    }
+    solver->nodes[node].firstChild = -1;
+    solver->nodes[node].expanded = false;
+}
+
+static bool IsSolved(const PnsNode *n) { return n->proof == 0 || n->disproof == 0; }
+
+static void SetSolved(PnsNode *n, bool proven)
+{
+    n->proof = proven ? 0 : PNS_INFINITY;
+    n->disproof = proven ? PNS_INFINITY : 0;
+}
+
+// Symmetric positions share one verdict, so the canonical key is used
+static uint64_t TableKey(const PnsSolver *solver)
+{
+    uint64_t key = BoardCanonicalHash(&solver->board, NULL);
+    return solver->attacker == PLAYER_O ? key ^ ATTACKER_O_KEY : key;
+}
+
+static void Remember(PnsSolver *solver, bool proven)
+{
+    uint64_t key = TableKey(solver);
+    PnsEntry *entry = &solver->table[key & solver->mask];
+    entry->key = key;
+    entry->result = proven ? PNS_PROVEN : PNS_DISPROVEN;
+}
+
+static void LookUp(PnsSolver *solver, PnsNode *n)
+{
+    uint64_t key = TableKey(solver);
+    const PnsEntry *entry = &solver->table[key & solver->mask];
+    if (entry->key == key && entry->result != 0) SetSolved(n, entry->result == PNS_PROVEN);
+}
+
+// A new leaf's numbers: finished games and known transpositions are final,
+// anything else starts at 1/1. A draw counts as a failure for the attacker.
+static void Evaluate(PnsSolver *solver, PnsNode *n, Cell mover)
+{
+    const Board *board = &solver->board;
+    if (BoardHasLine(board, mover)) SetSolved(n, mover == solver->attacker);
+    else if (BoardIsDrawn(board)) SetSolved(n, false);
+    else LookUp(solver, n);
+}
+
+static unsigned int AddNumbers(unsigned int a, unsigned int b)
+{
+    unsigned int sum = a + b;
+    return sum >= PNS_INFINITY ? PNS_INFINITY : sum;
+}
+
+// OR nodes need one proven child and every child disproven, AND nodes the reverse
+static void UpdateNode(PnsSolver *solver, int node)
+{
+    PnsNode *n = &solver->nodes[node];
+    unsigned int proof = n->isOr ? PNS_INFINITY : 0;
+    unsigned int disproof = n->isOr ? 0 : PNS_INFINITY;
+
+    for (int child = n->firstChild; child != -1; child = solver->nodes[child].nextSibling) {
+        const PnsNode *c = &solver->nodes[child];
+        if (n->isOr) {
+            if (c->proof < proof) proof = c->proof;
+            disproof = AddNumbers(disproof, c->disproof);
+        } else {
+            proof = AddNumbers(proof, c->proof);
+            if (c->disproof < disproof) disproof = c->disproof;
+        }
+    }
+    n->proof = proof;
+    n->disproof = disproof;
+}
+
+static int MostProvingChild(const PnsSolver *solver, int node)
+{
+    const PnsNode *n = &solver->nodes[node];
+    int best = n->firstChild;
+    for (int child = n->firstChild; child != -1; child = solver->nodes[child].nextSibling) {
+        const PnsNode *c = &solver->nodes[child];
+        if (n->isOr ? c->proof < solver->nodes[best].proof : c->disproof < solver->nodes[best].disproof) best = child;
+    }
+    return best;
+}
+
+// Makes room in a full pool. Solved subtrees go first, then unsolved nodes
+// are collapsed from the deepest level up until a quarter of the pool is
+// free; collapsed nodes keep their numbers and are expanded again if the
+// search comes back to them.
+static bool CollectGarbage(PnsSolver *solver, int root)
+{
+    int before = solver->live;
+    int maxDepth = 0;
+    solver->collections++;
+
+    for (int i = 0; i < solver->used; i++) {
+        PnsNode *n = &solver->nodes[i];
+        if (n->inUse && n->expanded && IsSolved(n)) FreeChildren(solver, i);
+    }
+    for (int i = 0; i < solver->used; i++) {
+        if (solver->nodes[i].inUse && solver->nodes[i].depth > maxDepth) maxDepth = solver->nodes[i].depth;
+    }
+
+    // The root keeps its children so the best move can still be read off them
+    for (int depth = maxDepth - 1; depth > solver->nodes[root].depth && solver->live > solver->capacity * 3 / 4; depth--) {
+        for (int i = 0; i < solver->used; i++) {
+            PnsNode *n = &solver->nodes[i];
+            if (n->inUse && n->expanded && n->depth == depth) FreeChildren(solver, i);
+        }
+    }
+    return solver->live < before;
+}
+
+static bool Prove(PnsSolver *solver, int root, long long maxIterations, bool secondLevel);
+
+// Adds a child per empty cell, false if the pool ran out (nothing is added then)
+static bool Expand(PnsSolver *solver, int node, bool secondLevel)
+{
+    Board *board = &solver->board;
+    Cell mover = BoardSideToMove(board);
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, cells);
+    int *link = &solver->nodes[node].firstChild;
+
+    for (int i = 0; i < count; i++) {
+        int child = AllocNode(solver, node, cells[i], !solver->nodes[node].isOr, solver->nodes[node].depth + 1);
+        if (child == -1) {
+            FreeChildren(solver, node);
+            return false;
+        }
+        *link = child;
+        link = &solver->nodes[child].nextSibling;
+
+        BoardMakeMove(board, cells[i], mover);
+        Evaluate(solver, &solver->nodes[child], mover);
+        BoardUnmakeMove(board);
+    }
+    solver->nodes[node].expanded = true;
+    if (secondLevel) return true;
+
+    // PN²: a short search under each new child seeds better numbers than 1/1,
+    // then its tree is dropped so only the first level stays in the pool. The
+    // second level grows with the first, so small problems stay cheap.
+    int budget = solver->live / 16 + 1;
+    if (budget > solver->secondLevel) budget = solver->secondLevel;
+    for (int child = solver->nodes[node].firstChild; child != -1; child = solver->nodes[child].nextSibling) {
+        if (IsSolved(&solver->nodes[child])) continue;
+        BoardMakeMove(board, solver->nodes[child].move, mover);
+        Prove(solver, child, budget, true);
+        BoardUnmakeMove(board);
+        FreeChildren(solver, child);
+    }
+    return true;
+}
+
+// The proof-number loop below `root`, with the board at root's position.
+// Returns false if the pool ran out and collecting garbage didn't help.
+static bool Prove(PnsSolver *solver, int root, long long maxIterations, bool secondLevel)
+{
+    Board *board = &solver->board;
+
+    for (long long iteration = 0; iteration < maxIterations && !IsSolved(&solver->nodes[root]); iteration++) {
+        int node = root;
+        while (solver->nodes[node].expanded) {
+            node = MostProvingChild(solver, node);
+            BoardMakeMove(board, solver->nodes[node].move, BoardSideToMove(board));
+        }
+
+        bool expanded = Expand(solver, node, secondLevel);
+
+        // Back the new numbers up to the root, taking the moves back on the way
+        for (;;) {
+            if (expanded) {
+                UpdateNode(solver, node);
+                if (IsSolved(&solver->nodes[node])) Remember(solver, solver->nodes[node].proof == 0);
+            }
+            if (node == root) break;
+            node = solver->nodes[node].parent;
+            BoardUnmakeMove(board);
+        }
+
+        if (!expanded && (secondLevel || !CollectGarbage(solver, root))) return false;
+    }
+    return true;
+}
+
+// Asks whether `attacker` wins from the solver's board; returns the root node
+static int Ask(PnsSolver *solver, Cell attacker, long long maxIterations)
+{
+    solver->attacker = attacker;
+    solver->freeList = -1;
+    solver->used = 0;
+    solver->live = 0;
+
+    // The root is always expanded, even when the table knows it, so a move can be read off
+    int root = AllocNode(solver, -1, -1, BoardSideToMove(&solver->board) == attacker, 0);
+    Prove(solver, root, maxIterations, false);
+    return root;
+}
+
+// First root child whose numbers match the wanted result
+static int SolvedChild(const PnsSolver *solver, int root, bool proven)
+{
+    for (int child = solver->nodes[root].firstChild; child != -1; child = solver->nodes[child].nextSibling) {
+        const PnsNode *c = &solver->nodes[child];
+        if (proven ? c->proof == 0 : c->disproof == 0) return c->move;
+    }
+    return solver->nodes[root].firstChild != -1 ? solver->nodes[solver->nodes[root].firstChild].move : -1;
+}
+
+PnsVerdict PnsSolve(PnsSolver *solver, const Board *board, long long maxIterations, PnsResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->verdict = PNS_UNKNOWN;
+    result->move = -1;
+
+    // Keys are only unique within one geometry
+    if (solver->board.geo != board->geo) memset(solver->table, 0, (solver->mask + 1) * sizeof(PnsEntry));
+    solver->board = *board;
+    solver->created = 0;
+    solver->collections = 0;
+
+    Cell mover = BoardSideToMove(board);
+    if (BoardHasLine(board, mover)) result->verdict = PNS_WIN;
+    else if (BoardHasLine(board, Opponent(mover))) result->verdict = PNS_LOSS;
+    else if (BoardIsDrawn(board)) result->verdict = PNS_DRAW;
+    if (result->verdict != PNS_UNKNOWN) {
+        result->proof = result->verdict == PNS_WIN ? 0 : PNS_INFINITY;
+        result->disproof = result->verdict == PNS_WIN ? PNS_INFINITY : 0;
+        return result->verdict;
+    }
+
+    int root = Ask(solver, mover, maxIterations);
+    result->proof = solver->nodes[root].proof;
+    result->disproof = solver->nodes[root].disproof;
+
+    if (result->proof == 0) {
+        result->verdict = PNS_WIN;
+        result->move = SolvedChild(solver, root, true);
+    } else if (result->disproof == 0) {
+        // No win, so the draw still has to be told apart from a loss
+        root = Ask(solver, Opponent(mover), maxIterations);
+        if (solver->nodes[root].proof == 0) {
+            result->verdict = PNS_LOSS;
+            result->move = SolvedChild(solver, root, true);
+        } else if (solver->nodes[root].disproof == 0) {
+            result->verdict = PNS_DRAW;
+            result->move = SolvedChild(solver, root, false);
+        }
+    }
+
+    result->nodes = solver->created;
+    result->collections = solver->collections;
+    return result->verdict;
+}
+
+const char *PnsVerdictName(PnsVerdict verdict)
+{
+    static const char *names[] = {"Unknown", "Loss", "Draw", "Win"};
+    return names[verdict];
+}
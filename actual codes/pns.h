@@ -0,0 +1,80 @@
+#ifndef PNS_H
+#define PNS_H
+
+#include "board.h"
+
+// Proof-number search (PN²) for exact won/drawn/lost verdicts.
+// Every node carries a proof number (how many leaves still have to be
+// proven to show the attacker wins) and a disproof number (the same for
+// showing it doesn't); the search keeps expanding the most-proving leaf
+// until the root is decided. Each newly expanded node gets a small
+// second-level search of its own to seed its numbers, after which that
+// subtree is thrown away again.
+//
+// Nodes come from a fixed pool. When it runs out, solved subtrees are
+// released first, then unsolved nodes deep in the tree are collapsed back
+// into leaves (keeping their numbers) until a quarter of the pool is free.
+// Solved positions are remembered in a small table, so transpositions are
+// only ever proven once.
+
+#define PNS_DEFAULT_NODES (1 << 16)
+#define PNS_DEFAULT_TABLE_BITS 16
+#define PNS_SECOND_LEVEL 64          // second-level expansions per new node
+#define PNS_INFINITY 0x3fffffffu
+#define PNS_PROVEN 1
+#define PNS_DISPROVEN 2
+
+typedef enum { PNS_UNKNOWN, PNS_LOSS, PNS_DRAW, PNS_WIN } PnsVerdict; // for the side to move
+
+typedef struct {
+    unsigned int proof;
+    unsigned int disproof;
+    int parent;
+    int firstChild;
+    int nextSibling;  // also links the free list
+    short move;
+    unsigned char depth;
+    bool isOr;        // the attacker is to move
+    bool expanded;
+    bool inUse;
+} PnsNode;
+
+typedef struct {
+    uint64_t key;     // position key, with the attacker mixed in
+    unsigned char result; // 0 = empty slot, PNS_PROVEN or PNS_DISPROVEN
+} PnsEntry;
+
+typedef struct {
+    PnsNode *nodes;
+    int capacity;
+    int used;         // high-water mark of the pool
+    int live;         // nodes currently allocated
+    int freeList;
+    PnsEntry *table;
+    size_t mask;
+    Board board;
+    Cell attacker;
+    int secondLevel;
+    long long created;
+    int collections;
+} PnsSolver;
+
+typedef struct {
+    PnsVerdict verdict;
+    int move;             // a move that keeps the verdict, -1 if unknown
+    unsigned int proof;   // root numbers of the "side to move wins" search
+    unsigned int disproof;
+    long long nodes;      // nodes created, second-level ones included
+    int collections;      // garbage collections that were needed
+} PnsResult;
+
+bool PnsInit(PnsSolver *solver, int capacity, int tableBits);
+void PnsFree(PnsSolver *solver);
+
+// Solves the position with at most maxIterations first-level expansions for
+// each of the two questions asked (does the side to move win, does it lose)
+PnsVerdict PnsSolve(PnsSolver *solver, const Board *board, long long maxIterations, PnsResult *result);
+
+const char *PnsVerdictName(PnsVerdict verdict);
+
+#endif // PNS_H
@@ -0,0 +1,125 @@
+#include "profiler.h"
+#include "platform.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_MASK (PROFILER_RING_SIZE - 1)
+
+static FrameSample ring[PROFILER_RING_SIZE];
+static atomic_ullong written;   // samples pushed so far; only the UI thread advances it
+
+static FrameSample current;
+static uint64_t lastFrameNs;
+static ProfileSection stack[PROFILER_MAX_DEPTH];
+static int depth;
+static uint64_t sectionStartNs;  // when the open section last resumed
+
+void ProfilerBeginFrame(void)
+{
+    uint64_t frame = current.frame;
+    memset(&current, 0, sizeof(current));
+    current.frame = frame;
+    depth = 0;
+    if (lastFrameNs == 0) lastFrameNs = TimerNowNs();
+    TRACE_BEGIN("frame");
+}
+
+void ProfilerEndFrame(bool waited)
+{
+    uint64_t now = TimerNowNs();
+    current.intervalNs = now - lastFrameNs;
+    current.waited = waited;
+    lastFrameNs = now;
+
+    if (TraceEnabled()) {
+        uint64_t work = 0;
+        for (int s = 0; s < PROFILE_SECTIONS; s++) work += current.sectionNs[s];
+        if (work > (uint64_t)PROFILER_STALL_MS * 1000000) TraceEmit('i', "frame stall", 0);
+        TraceEmit('E', "frame", 0);
+    }
+
+    // The slot is filled before the count that publishes it
+    uint64_t index = atomic_load_explicit(&written, memory_order_relaxed);
+    ring[index & RING_MASK] = current;
+    atomic_store_explicit(&written, index + 1, memory_order_release);
+    current.frame++;
+}
+
+void ProfilerPush(ProfileSection section)
+{
+    uint64_t now = TimerNowNs();
+    if (depth > 0) current.sectionNs[stack[depth - 1]] += now - sectionStartNs;
+    if (depth < PROFILER_MAX_DEPTH) stack[depth] = section;
+    depth++;
+    sectionStartNs = now;
+    TRACE_BEGIN(ProfileSectionName(section));
+}
+
+void ProfilerPop(void)
+{
+    uint64_t now = TimerNowNs();
+    if (depth == 0) return;
+    depth--;
+    if (depth < PROFILER_MAX_DEPTH) {
+        current.sectionNs[stack[depth]] += now - sectionStartNs;
+        TRACE_END(ProfileSectionName(stack[depth]));
+    }
+    sectionStartNs = now;
+}
+
+void ProfilerCountDraws(int count)
+{
+    current.drawCalls += (uint32_t)count;
+}
+
+int ProfilerSnapshot(FrameSample *samples, int max)
+{
+    uint64_t end = atomic_load_explicit(&written, memory_order_acquire);
+    uint64_t count = end < PROFILER_RING_SIZE ? end : PROFILER_RING_SIZE;
+    if (count > (uint64_t)max) count = (uint64_t)max;
+    uint64_t begin = end - count;
+    for (uint64_t i = begin; i < end; i++) samples[i - begin] = ring[i & RING_MASK];
+
+    // Anything the writer lapped while we copied is dropped
+    uint64_t after = atomic_load_explicit(&written, memory_order_acquire);
+    uint64_t overwritten = after > PROFILER_RING_SIZE ? after - PROFILER_RING_SIZE : 0;
+    if (overwritten > begin) {
+        uint64_t skip = overwritten - begin;
+        if (skip >= count) return 0;
+        memmove(samples, samples + skip, sizeof(FrameSample) * (count - skip));
+        count -= skip;
+    }
+    return (int)count;
+}
+
+const char *ProfileSectionName(ProfileSection section)
+{
+    static const char *names[PROFILE_SECTIONS] = {"input", "ai", "analysis", "draw"};
+    return section < PROFILE_SECTIONS ? names[section] : "?";
+}
+
+bool ProfilerWriteTrace(const char *path)
+{
+    FrameSample *samples = malloc(sizeof(FrameSample) * PROFILER_RING_SIZE);
+    if (samples == NULL) return false;
+    int count = ProfilerSnapshot(samples, PROFILER_RING_SIZE);
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        free(samples);
+        return false;
+    }
+    fprintf(file, "frame,interval_ms,waited");
+    for (int s = 0; s < PROFILE_SECTIONS; s++) fprintf(file, ",%s_ms", ProfileSectionName(s));
+    fprintf(file, ",draw_calls\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%llu,%.3f,%d", (unsigned long long)samples[i].frame, samples[i].intervalNs / 1e6, samples[i].waited);
+        for (int s = 0; s < PROFILE_SECTIONS; s++) fprintf(file, ",%.3f", samples[i].sectionNs[s] / 1e6);
+        fprintf(file, ",%u\n", samples[i].drawCalls);
+    }
+
+    free(samples);
+    return fclose(file) == 0;
+}
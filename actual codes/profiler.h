@@ -0,0 +1,55 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame profiler for the UI thread. Timers are scoped and nest: while a
+// section is open, time is charged to it alone, so AI time inside input
+// handling isn't counted twice. Each frame ends with one sample pushed into
+// a lock-free ring (one writer, readers on any thread), which feeds the
+// on-screen overlay and can be written out as a trace file. With event
+// tracing on, frames and sections also show up as trace events.
+
+#define PROFILER_RING_SIZE 1024    // frames kept, a power of two
+#define PROFILER_MAX_DEPTH 8
+#define PROFILER_DEFAULT_FILE "frame_trace.csv"
+#define PROFILER_STALL_MS 50       // frames with more work than this are marked in the trace
+
+typedef enum {
+    PROFILE_INPUT,      // hit testing and input handlers
+    PROFILE_AI,         // the AI choosing a move
+    PROFILE_ANALYSIS,   // dataset evaluation and last-game analysis
+    PROFILE_DRAW,       // the Draw* functions
+    PROFILE_SECTIONS
+} ProfileSection;
+
+typedef struct {
+    uint64_t frame;
+    uint64_t intervalNs;                    // since the previous frame ended
+    uint64_t sectionNs[PROFILE_SECTIONS];
+    uint32_t drawCalls;
+    bool waited;                            // the interval includes blocking on input
+} FrameSample;
+
+void ProfilerBeginFrame(void);
+void ProfilerEndFrame(bool waited);
+
+void ProfilerPush(ProfileSection section);
+void ProfilerPop(void);
+
+// Times the statement or block that follows it
+#define PROFILE_SCOPE(section) \
+    for (int profileOnce_ = (ProfilerPush(section), 1); profileOnce_; profileOnce_ = (ProfilerPop(), 0))
+
+// Primitives handed to raylib: glyphs, texture blits, rectangles
+void ProfilerCountDraws(int count);
+
+// Copies the newest samples, oldest first, and returns how many
+int ProfilerSnapshot(FrameSample *samples, int max);
+
+const char *ProfileSectionName(ProfileSection section);
+bool ProfilerWriteTrace(const char *path);
+
+#endif // PROFILER_H
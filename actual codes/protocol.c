@@ -0,0 +1,278 @@
+#include "protocol.h"
+#include "platform.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    const Tablebase *tablebase;
+    const BoardGeometry *geo;
+    EngineConfig config;
+    Engine engine;
+    Board board;
+    pthread_t thread;
+    bool searching;
+    bool infinite;             // only ends on stop
+    atomic_bool stop;
+    uint64_t start;
+    pthread_mutex_t output;    // info lines come from the search thread
+} ProtocolState;
+
+static void Send(ProtocolState *state, const char *format, ...)
+{
+    va_list args;
+    pthread_mutex_lock(&state->output);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+    fflush(stdout);
+    pthread_mutex_unlock(&state->output);
+}
+
+static const char *FormatMove(const BoardGeometry *geo, int move, char *buffer)
+{
+    if (move < 0) return "0000";
+    snprintf(buffer, 16, "%c%d", 'a' + move % geo->size, move / geo->size + 1);
+    return buffer;
+}
+
+static int ParseMove(const BoardGeometry *geo, const char *text)
+{
+    int column = text[0] - 'a';
+    int row = atoi(text + 1) - 1;
+    if (column < 0 || column >= geo->size || row < 0 || row >= geo->size) return -1;
+    return row * geo->size + column;
+}
+
+static bool GameOver(const Board *board)
+{
+    return BoardHasLine(board, PLAYER_X) || BoardHasLine(board, PLAYER_O) || BoardEmptyCount(board) == 0;
+}
+
+// Forced results are reported as moves to mate, the way chess engines do
+static void FormatScore(int score, char *buffer, int size)
+{
+    if (SearchIsWin(score) || SearchIsLoss(score)) {
+        int moves = (SEARCH_WIN - abs(score) + 1) / 2;
+        snprintf(buffer, size, "mate %d", score > 0 ? moves : -moves);
+    } else {
+        snprintf(buffer, size, "cp %d", score);
+    }
+}
+
+static void ReportIteration(const SearchResult *result, void *context)
+{
+    ProtocolState *state = context;
+    char line[PROTOCOL_MAX_LINE], score[32], move[16];
+    uint64_t elapsedNs = TimerNowNs() - state->start;
+    long long nps = elapsedNs > 0 ? (long long)(result->nodes * 1e9 / elapsedNs) : 0;
+
+    FormatScore(result->score, score, sizeof(score));
+    int length = snprintf(line, sizeof(line), "info depth %d score %s nodes %lld nps %lld time %llu pv",
+                          result->depth, score, result->nodes, nps, (unsigned long long)(elapsedNs / 1000000));
+    for (int i = 0; i < result->pvLength && length < (int)sizeof(line) - 16; i++) {
+        length += snprintf(line + length, sizeof(line) - length, " %s", FormatMove(state->geo, result->pv[i], move));
+    }
+    Send(state, "%s", line);
+}
+
+// A fresh engine: new config, new board size or a new game
+static void ResetEngine(ProtocolState *state)
+{
+    EngineFree(&state->engine);
+    EngineInit(&state->engine, &state->config, state->tablebase, TimerNowNs());
+    state->engine.stop = &state->stop;
+    state->engine.progress = ReportIteration;
+    state->engine.progressContext = state;
+}
+
+static void *SearchThreadMain(void *arg)
+{
+    ProtocolState *state = arg;
+    Engine *engine = &state->engine;
+    Board board = state->board;
+    char move[16];
+    TraceThreadName("search");
+
+    engine->lastResult.move = -1;
+    engine->lastThreat.win = false;
+    int best = GameOver(&board) ? -1 : EngineChooseMove(engine, &board);
+    if (engine->lastThreat.win) {
+        Send(state, "info string forced win depth %d nodes %lld", engine->lastThreat.depth, engine->lastThreat.nodes);
+    }
+    Send(state, "bestmove %s", FormatMove(state->geo, best, move));
+    return NULL;
+}
+
+// Waits for the running search, cutting it short if asked to or if it would never end
+static void FinishSearch(ProtocolState *state, bool stop)
+{
+    if (!state->searching) return;
+    if (stop || state->infinite) atomic_store(&state->stop, true);
+    pthread_join(state->thread, NULL);
+    state->searching = false;
+}
+
+// go [depth N] [movetime MS] [infinite]
+static void Go(ProtocolState *state, char *args)
+{
+    int depth = 0;
+    long long movetime = 0;
+    bool infinite = false;
+    for (char *token = strtok(args, " \t\r\n"); token != NULL; token = strtok(NULL, " \t\r\n")) {
+        char *value = NULL;
+        if (strcmp(token, "infinite") == 0) infinite = true;
+        else if (strcmp(token, "depth") == 0 && (value = strtok(NULL, " \t\r\n")) != NULL) depth = atoi(value);
+        else if (strcmp(token, "movetime") == 0 && (value = strtok(NULL, " \t\r\n")) != NULL) movetime = atoll(value);
+    }
+
+    // Without a depth, time-limited searches go as deep as the board allows
+    Engine *engine = &state->engine;
+    engine->config.depthLimit = depth > 0 ? depth : (movetime > 0 || infinite) ? state->geo->cellCount : state->config.depthLimit;
+    state->start = TimerNowNs();
+    engine->deadline = movetime > 0 ? state->start + (uint64_t)movetime * 1000000 : 0;
+    atomic_store(&state->stop, false);
+    state->infinite = infinite && depth == 0 && movetime == 0;
+
+    if (pthread_create(&state->thread, NULL, SearchThreadMain, state) != 0) {
+        Send(state, "bestmove 0000");
+        return;
+    }
+    state->searching = true;
+}
+
+// position [startpos | cells x,o,b,...] [moves b2 a1 ...]
+static void Position(ProtocolState *state, char *args)
+{
+    Board *board = &state->board;
+    BoardInit(board, state->geo);
+
+    char *token = strtok(args, " \t\r\n");
+    if (token != NULL && strcmp(token, "cells") == 0) {
+        Cell cells[BOARD_MAX_CELLS];
+        char *list = strtok(NULL, " \t\r\n");
+        int count = 0;
+        for (const char *p = list; p != NULL && *p != '\0' && count < state->geo->cellCount; p++) {
+            if (*p == 'x' || *p == 'X') cells[count++] = PLAYER_X;
+            else if (*p == 'o' || *p == 'O') cells[count++] = PLAYER_O;
+            else if (*p == 'b' || *p == '.') cells[count++] = EMPTY;
+        }
+        if (count != state->geo->cellCount) {
+            Send(state, "info string expected %d cells", state->geo->cellCount);
+            return;
+        }
+        BoardFromCells(board, state->geo, cells);
+        token = strtok(NULL, " \t\r\n");
+    } else if (token != NULL && strcmp(token, "startpos") == 0) {
+        token = strtok(NULL, " \t\r\n");
+    }
+
+    if (token == NULL || strcmp(token, "moves") != 0) return;
+    while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+        int move = ParseMove(state->geo, token);
+        if (move < 0 || BoardGetCell(board, move) != EMPTY || GameOver(board)) {
+            Send(state, "info string illegal move %s", token);
+            return;
+        }
+        BoardMakeMove(board, move, BoardSideToMove(board));
+    }
+}
+
+// setoption name <Engine|Board> value <...>
+static void SetOption(ProtocolState *state, char *args)
+{
+    char name[64], value[256];
+    if (sscanf(args, " name %63s value %255s", name, value) != 2) {
+        Send(state, "info string usage: setoption name <Engine|Board> value <...>");
+        return;
+    }
+
+    if (strcmp(name, "Engine") == 0) {
+        EngineConfig config;
+        if (!EngineConfigParse(value, &config)) {
+            Send(state, "info string bad engine spec %s", value);
+            return;
+        }
+        state->config = config;
+    } else if (strcmp(name, "Board") == 0) {
+        int size, columns, winLength;
+        const BoardGeometry *geo = NULL;
+        if (sscanf(value, "%dx%dk%d", &size, &columns, &winLength) == 3 && columns == size) {
+            geo = BoardGeometryGet(size, winLength);
+        }
+        if (geo == NULL) {
+            Send(state, "info string bad board %s", value);
+            return;
+        }
+        // Table keys are only unique within one geometry, hence the engine reset below
+        state->geo = geo;
+        BoardInit(&state->board, geo);
+    } else {
+        Send(state, "info string unknown option %s", name);
+        return;
+    }
+    ResetEngine(state);
+}
+
+int ProtocolMain(int argc, char **argv, const Tablebase *tablebase)
+{
+    ProtocolState *state = calloc(1, sizeof(ProtocolState));
+    if (state == NULL) return 1;
+
+    state->tablebase = tablebase;
+    state->geo = BoardGeometryGet(3, 3);
+    state->config = EngineConfigDefault(ENGINE_MINIMAX, HARD);
+    if (argc > 0 && !EngineConfigParse(argv[0], &state->config)) {
+        printf("Usage: --protocol [engine]\n");
+        free(state);
+        return 1;
+    }
+    pthread_mutex_init(&state->output, NULL);
+    BoardInit(&state->board, state->geo);
+    ResetEngine(state);
+
+    char line[PROTOCOL_MAX_LINE];
+    while (fgets(line, sizeof(line), stdin)) {
+        char *command = strtok(line, " \t\r\n");
+        char *args = strtok(NULL, "\r\n");
+        if (command == NULL) continue;
+        if (args == NULL) args = "";
+
+        // Anything but isready waits for a running search first
+        if (strcmp(command, "isready") == 0) {
+            Send(state, "readyok");
+            continue;
+        }
+        FinishSearch(state, strcmp(command, "stop") == 0 || strcmp(command, "quit") == 0);
+
+        if (strcmp(command, "uci") == 0) {
+            char name[64];
+            Send(state, "id name Tic-Tac-Toe");
+            Send(state, "option name Engine type string default %s", EngineConfigName(&state->config, name, sizeof(name)));
+            Send(state, "option name Board type string default %dx%dk%d", state->geo->size, state->geo->size, state->geo->winLength);
+            Send(state, "uciok");
+        } else if (strcmp(command, "setoption") == 0) {
+            SetOption(state, args);
+        } else if (strcmp(command, "ucinewgame") == 0) {
+            BoardInit(&state->board, state->geo);
+            ResetEngine(state);
+        } else if (strcmp(command, "position") == 0) {
+            Position(state, args);
+        } else if (strcmp(command, "go") == 0) {
+            Go(state, args);
+        } else if (strcmp(command, "quit") == 0) {
+            break;
+        } else if (strcmp(command, "stop") != 0) {
+            Send(state, "info string unknown command %s", command);
+        }
+    }
+
+    FinishSearch(state, true);
+    EngineFree(&state->engine);
+    pthread_mutex_destroy(&state->output);
+    free(state);
+    return 0;
+}
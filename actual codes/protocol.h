@@ -0,0 +1,28 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "engine.h"
+
+// Line-oriented engine protocol on stdin/stdout, modelled on UCI, so that
+// tournament managers and test harnesses can drive the same engine the
+// game uses without a window. Commands:
+//   uci                                  -> id / option lines, then uciok
+//   isready                              -> readyok
+//   setoption name Engine value <spec>   engine spec as for --arena
+//   setoption name Board value <NxNkK>
+//   ucinewgame                           forget the search tables
+//   position [startpos | cells x,o,b,...] [moves b2 a1 ...]
+//   go [depth N] [movetime MS] [infinite] -> info lines, then bestmove
+//   stop, quit
+// Cells are named by column letter and row number, "a1" being top left.
+// The search runs on its own thread, so stop is answered while it thinks
+// (other commands wait for the bestmove, except after go infinite);
+// every completed iteration of the negamax search streams an info line
+// with depth, score, nodes, nps, time and the principal variation.
+
+#define PROTOCOL_MAX_LINE 4096
+
+// Entry point for "--protocol [engine]"
+int ProtocolMain(int argc, char **argv, const Tablebase *tablebase);
+
+#endif // PROTOCOL_H
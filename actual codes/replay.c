@@ -0,0 +1,212 @@
+#include "replay.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// This frame's input
+static Vector2 mouse = { 0, 0 };
+static bool clicked = false;
+static float wheel = 0.0f;
+static int keys[INPUT_MAX_KEYS];
+static int keyCount = 0;
+static uint32_t frames = 0;     // frames begun so far
+
+static FILE *recordFile = NULL;
+static uint64_t recordStartNs = 0;
+
+static InputEvent *replayEvents = NULL;
+static size_t replayCount = 0;
+static size_t replayNext = 0;
+static size_t valueNext = 0;    // the next INPUT_VALUE to look at
+
+static void RecordEvent(uint32_t frame, InputEventType type, int key, float x, float y)
+{
+    InputEvent event = { TimerNowNs() - recordStartNs, frame, (uint16_t)type, (uint16_t)key, x, y, 0, 0 };
+    fwrite(&event, sizeof(event), 1, recordFile);
+}
+
+static void PollWindow(uint32_t frame)
+{
+    Vector2 position = GetMousePosition();
+    if (position.x != mouse.x || position.y != mouse.y) {
+        mouse = position;
+        if (recordFile != NULL) RecordEvent(frame, INPUT_MOUSE_MOVE, 0, mouse.x, mouse.y);
+    }
+
+    clicked = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    if (clicked && recordFile != NULL) RecordEvent(frame, INPUT_MOUSE_PRESS, 0, mouse.x, mouse.y);
+
+    wheel = GetMouseWheelMove();
+    if (wheel != 0.0f && recordFile != NULL) RecordEvent(frame, INPUT_MOUSE_WHEEL, 0, wheel, 0);
+
+    for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+        if (keyCount == INPUT_MAX_KEYS) continue;
+        keys[keyCount++] = key;
+        if (recordFile != NULL) RecordEvent(frame, INPUT_KEY_PRESS, key, 0, 0);
+    }
+}
+
+static bool PlayFrame(uint32_t frame)
+{
+    while (replayNext < replayCount && replayEvents[replayNext].frame == frame) {
+        const InputEvent *event = &replayEvents[replayNext++];
+        switch (event->type) {
+            case INPUT_MOUSE_MOVE:
+                mouse = (Vector2){ event->x, event->y };
+                break;
+            case INPUT_MOUSE_PRESS:
+                mouse = (Vector2){ event->x, event->y };
+                clicked = true;
+                break;
+            case INPUT_MOUSE_WHEEL:
+                wheel += event->x;
+                break;
+            case INPUT_KEY_PRESS:
+                if (keyCount < INPUT_MAX_KEYS) keys[keyCount++] = event->key;
+                break;
+            case INPUT_END:
+                return false;
+            case INPUT_VALUE:
+                break;      // taken by ReplayNextValue
+        }
+    }
+
+    // A session cut short (the game crashed) ends with its last event
+    return replayNext < replayCount || (replayCount > 0 && frame == replayEvents[replayCount - 1].frame);
+}
+
+bool InputBeginFrame(void)
+{
+    clicked = false;
+    wheel = 0.0f;
+    keyCount = 0;
+
+    uint32_t frame = frames++;
+    if (replayEvents != NULL) return PlayFrame(frame);
+    PollWindow(frame);
+    return true;
+}
+
+bool InputClicked(void)
+{
+    return clicked;
+}
+
+Vector2 InputMouse(void)
+{
+    return mouse;
+}
+
+float InputWheel(void)
+{
+    return wheel;
+}
+
+bool InputKeyPressed(int key)
+{
+    for (int i = 0; i < keyCount; i++) {
+        if (keys[i] == key) return true;
+    }
+    return false;
+}
+
+void ReplayRecordValue(uint32_t value)
+{
+    if (recordFile == NULL) return;
+    InputEvent event = { TimerNowNs() - recordStartNs, frames > 0 ? frames - 1 : 0, INPUT_VALUE, 0, 0, 0, value, 0 };
+    fwrite(&event, sizeof(event), 1, recordFile);
+}
+
+bool ReplayNextValue(uint32_t *value)
+{
+    if (replayEvents == NULL) return false;
+    while (valueNext < replayCount && replayEvents[valueNext].type != INPUT_VALUE) valueNext++;
+    if (valueNext == replayCount) return false;
+    *value = replayEvents[valueNext++].value;
+    return true;
+}
+
+bool ReplayRecordStart(const char *path, uint64_t engineSeed, uint32_t menuSeed)
+{
+    ReplayRecordStop();
+    recordFile = fopen(path, "wb");
+    if (recordFile == NULL) {
+        printf("Error creating %s!\n", path);
+        return false;
+    }
+
+    ReplayHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TTTR", 4);
+    header.version = REPLAY_VERSION;
+    header.engineSeed = engineSeed;
+    header.menuSeed = menuSeed;
+    fwrite(&header, sizeof(header), 1, recordFile);
+
+    recordStartNs = TimerNowNs();
+    frames = 0;
+    return true;
+}
+
+void ReplayRecordStop(void)
+{
+    if (recordFile == NULL) return;
+    RecordEvent(frames, INPUT_END, 0, 0, 0);
+    if (ferror(recordFile) | fclose(recordFile)) printf("Error writing the input recording!\n");
+    recordFile = NULL;
+}
+
+bool ReplayLoad(const char *path, ReplayHeader *header)
+{
+    ReplayFree();
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error opening %s!\n", path);
+        return false;
+    }
+
+    long size = -1;
+    bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+              memcmp(header->magic, "TTTR", 4) == 0 && header->version == REPLAY_VERSION &&
+              fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= (long)sizeof(*header) &&
+              fseek(file, sizeof(*header), SEEK_SET) == 0;
+
+    if (ok) {
+        replayCount = (size_t)(size - (long)sizeof(*header)) / sizeof(InputEvent);
+        replayEvents = malloc((replayCount ? replayCount : 1) * sizeof(InputEvent));
+        ok = replayEvents != NULL && fread(replayEvents, sizeof(InputEvent), replayCount, file) == replayCount;
+    }
+
+    // Events have to come in frame order for PlayFrame
+    for (size_t i = 1; ok && i < replayCount; i++) {
+        ok = replayEvents[i].frame >= replayEvents[i - 1].frame;
+    }
+    fclose(file);
+
+    if (!ok) {
+        printf("Error reading %s, it is not an input recording!\n", path);
+        ReplayFree();
+        return false;
+    }
+
+    replayNext = 0;
+    valueNext = 0;
+    frames = 0;
+    mouse = (Vector2){ 0, 0 };
+    return true;
+}
+
+void ReplayFree(void)
+{
+    free(replayEvents);
+    replayEvents = NULL;
+    replayCount = 0;
+    replayNext = 0;
+    valueNext = 0;
+}
+
+double ReplaySeconds(void)
+{
+    return replayCount ? replayEvents[replayCount - 1].timeNs / 1e9 : 0.0;
+}
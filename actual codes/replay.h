@@ -0,0 +1,73 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Input recording and replay. The game reads the mouse and keyboard through
+// this layer instead of raylib: each frame's input is polled once, and while
+// recording every change is appended to a session file with its frame number
+// and time. The file also keeps the seeds of the engine's and raylib's random
+// generators, so a replay feeds the same input, frame by frame, to the same
+// game, and needs no window to do it. What input alone does not decide,
+// such as which learned model a game was played with, is recorded as values
+// the replay hands back in the same order.
+
+#define REPLAY_VERSION 2
+#define INPUT_MAX_KEYS 8    // key presses kept per frame
+
+typedef enum {
+    INPUT_MOUSE_MOVE,       // x, y: the new position
+    INPUT_MOUSE_PRESS,      // left button went down at x, y
+    INPUT_MOUSE_WHEEL,      // x: wheel movement
+    INPUT_KEY_PRESS,        // key: raylib key code
+    INPUT_END,              // the session's last frame ended before this one
+    INPUT_VALUE             // value: see ReplayRecordValue
+} InputEventType;
+
+typedef struct {
+    char magic[4];          // "TTTR"
+    uint32_t version;
+    uint64_t engineSeed;    // given to EngineInit
+    uint32_t menuSeed;      // given to SetRandomSeed, for the title animation
+    uint32_t reserved;
+} ReplayHeader;
+
+typedef struct {
+    uint64_t timeNs;        // since recording started
+    uint32_t frame;
+    uint16_t type;
+    uint16_t key;
+    float x;
+    float y;
+    uint32_t value;
+    uint32_t reserved;
+} InputEvent;
+
+// Polls the window's input, or takes the next frame of a loaded replay.
+// False once the replay has no frames left.
+bool InputBeginFrame(void);
+
+bool InputClicked(void);            // left button went down this frame
+Vector2 InputMouse(void);
+float InputWheel(void);
+bool InputKeyPressed(int key);
+
+// Appends every frame's input to path until ReplayRecordStop
+bool ReplayRecordStart(const char *path, uint64_t engineSeed, uint32_t menuSeed);
+void ReplayRecordStop(void);
+
+// Keeps a value the game goes on to depend on, when recording
+void ReplayRecordValue(uint32_t value);
+
+// The next value recorded, while replaying; false otherwise or once there
+// are none left
+bool ReplayNextValue(uint32_t *value);
+
+// Reads a whole session into memory; InputBeginFrame then plays it back
+bool ReplayLoad(const char *path, ReplayHeader *header);
+void ReplayFree(void);
+double ReplaySeconds(void);         // length of the loaded session as recorded
+
+#endif // REPLAY_H
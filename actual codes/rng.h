@@ -0,0 +1,34 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small xorshift64* generator so engines can run without touching shared random state
+
+static inline uint64_t RngNext(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform value in [0, bound)
+static inline int RngRange(uint64_t *state, int bound)
+{
+    return (int)(((RngNext(state) >> 32) * (uint64_t)bound) >> 32);
+}
+
+static inline uint64_t RngSeed(uint64_t seed)
+{
+    // splitmix64 finaliser so nearby seeds give unrelated streams, never zero
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    seed ^= seed >> 31;
+    return seed ? seed : 1;
+}
+
+#endif // RNG_H
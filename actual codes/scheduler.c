@@ -0,0 +1,353 @@
+#include "scheduler.h"
+#include "platform.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEQUE_MASK (SCHEDULER_DEQUE_SIZE - 1)
+
+typedef struct {
+    atomic_llong top;       // stolen from
+    atomic_llong bottom;    // pushed and popped by the owner
+    _Atomic(Task *) tasks[SCHEDULER_DEQUE_SIZE];
+} TaskDeque;
+
+typedef struct {
+    Scheduler *scheduler;
+    int index;
+    pthread_t thread;
+} SchedulerWorker;
+
+struct Scheduler {
+    int threads;                // deques; a worker that failed to start just leaves its own empty
+    int running;
+    bool pinThreads;
+    TaskDeque *deques;
+    SchedulerWorker *workers;
+
+    pthread_mutex_t lock;       // injection queue, sleeping and joining
+    pthread_cond_t wake;        // idle workers
+    pthread_cond_t joined;      // non-worker threads waiting on a group
+    Task *injectedHead;
+    Task *injectedTail;
+    atomic_int injected;
+    atomic_int sleepers;
+    atomic_uint epoch;          // bumped on every spawn so sleepers can't miss one
+    atomic_bool stopping;
+};
+
+static _Thread_local Scheduler *currentScheduler;
+static _Thread_local int currentWorker = -1;
+
+static pthread_once_t sharedOnce = PTHREAD_ONCE_INIT;
+static Scheduler *shared;
+static int sharedThreads;
+static bool sharedPinThreads;
+
+// Chase-Lev deque, in the C11 formulation of Le et al. ("Correct and
+// efficient work-stealing for weak memory models")
+
+static bool DequePush(TaskDeque *deque, Task *task)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= SCHEDULER_DEQUE_SIZE) return false;
+
+    atomic_store_explicit(&deque->tasks[bottom & DEQUE_MASK], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+static Task *DequePop(TaskDeque *deque)
+{
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+    Task *task = atomic_load_explicit(&deque->tasks[bottom & DEQUE_MASK], memory_order_relaxed);
+    if (top == bottom) {
+        // Last task: race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static Task *DequeSteal(TaskDeque *deque)
+{
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) return NULL;
+
+    Task *task = atomic_load_explicit(&deque->tasks[top & DEQUE_MASK], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+static Task *PopInjected(Scheduler *scheduler)
+{
+    if (atomic_load_explicit(&scheduler->injected, memory_order_relaxed) == 0) return NULL;
+
+    pthread_mutex_lock(&scheduler->lock);
+    Task *task = scheduler->injectedHead;
+    if (task != NULL) {
+        scheduler->injectedHead = task->next;
+        if (scheduler->injectedHead == NULL) scheduler->injectedTail = NULL;
+        atomic_fetch_sub(&scheduler->injected, 1);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+    return task;
+}
+
+// Own deque first (newest task, still warm in cache), then the injection
+// queue, then the oldest task of the other workers in turn
+static Task *FindTask(Scheduler *scheduler, int self)
+{
+    Task *task = DequePop(&scheduler->deques[self]);
+    if (task == NULL) task = PopInjected(scheduler);
+    for (int i = 1; i < scheduler->threads && task == NULL; i++) {
+        task = DequeSteal(&scheduler->deques[(self + i) % scheduler->threads]);
+    }
+    return task;
+}
+
+static void RunTask(Scheduler *scheduler, Task *task)
+{
+    TaskGroup *group = task->group;
+    task->run(task->arg);
+
+    // The group may be gone as soon as pending reaches zero, so only the scheduler is touched after
+    if (atomic_fetch_sub_explicit(&group->pending, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&scheduler->lock);
+        pthread_cond_broadcast(&scheduler->joined);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+}
+
+static void *SchedulerWorkerMain(void *arg)
+{
+    SchedulerWorker *worker = arg;
+    Scheduler *scheduler = worker->scheduler;
+    currentScheduler = scheduler;
+    currentWorker = worker->index;
+    if (scheduler->pinThreads) PinThread(worker->index % CpuCount());
+    if (TraceEnabled()) {
+        char name[32];
+        snprintf(name, sizeof(name), "worker %d", worker->index);
+        TraceThreadName(name);
+    }
+
+    int idle = 0;
+    while (!atomic_load(&scheduler->stopping)) {
+        unsigned int epoch = atomic_load(&scheduler->epoch);
+        Task *task = FindTask(scheduler, worker->index);
+        if (task != NULL) {
+            RunTask(scheduler, task);
+            idle = 0;
+            continue;
+        }
+        if (++idle < SCHEDULER_SPINS) {
+            ThreadYield();
+            continue;
+        }
+
+        // Sleep unless something was spawned since the scan above
+        atomic_fetch_add(&scheduler->sleepers, 1);
+        pthread_mutex_lock(&scheduler->lock);
+        if (atomic_load(&scheduler->epoch) == epoch && !atomic_load(&scheduler->stopping)) {
+            pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+        }
+        pthread_mutex_unlock(&scheduler->lock);
+        atomic_fetch_sub(&scheduler->sleepers, 1);
+        idle = 0;
+    }
+    return NULL;
+}
+
+Scheduler *SchedulerCreate(int threads, bool pinThreads)
+{
+    if (threads <= 0) threads = CpuCount();
+    if (threads > SCHEDULER_MAX_THREADS) threads = SCHEDULER_MAX_THREADS;
+
+    Scheduler *scheduler = calloc(1, sizeof(Scheduler));
+    if (scheduler == NULL) return NULL;
+    scheduler->deques = calloc((size_t)threads, sizeof(TaskDeque));
+    scheduler->workers = calloc((size_t)threads, sizeof(SchedulerWorker));
+    if (scheduler->deques == NULL || scheduler->workers == NULL) {
+        free(scheduler->deques);
+        free(scheduler->workers);
+        free(scheduler);
+        return NULL;
+    }
+
+    scheduler->pinThreads = pinThreads;
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->wake, NULL);
+    pthread_cond_init(&scheduler->joined, NULL);
+
+    scheduler->threads = threads;
+    for (int i = 0; i < threads; i++) {
+        scheduler->workers[i].scheduler = scheduler;
+        scheduler->workers[i].index = i;
+        if (pthread_create(&scheduler->workers[i].thread, NULL, SchedulerWorkerMain, &scheduler->workers[i]) != 0) break;
+        scheduler->running++;
+    }
+    if (scheduler->running == 0) {
+        SchedulerDestroy(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+void SchedulerDestroy(Scheduler *scheduler)
+{
+    if (scheduler == NULL) return;
+
+    atomic_store(&scheduler->stopping, true);
+    pthread_mutex_lock(&scheduler->lock);
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+    for (int i = 0; i < scheduler->running; i++) pthread_join(scheduler->workers[i].thread, NULL);
+
+    pthread_mutex_destroy(&scheduler->lock);
+    pthread_cond_destroy(&scheduler->wake);
+    pthread_cond_destroy(&scheduler->joined);
+    free(scheduler->deques);
+    free(scheduler->workers);
+    free(scheduler);
+}
+
+static void CreateShared(void)
+{
+    shared = SchedulerCreate(sharedThreads, sharedPinThreads);
+}
+
+Scheduler *SchedulerShared(void)
+{
+    pthread_once(&sharedOnce, CreateShared);
+    return shared;
+}
+
+void SchedulerConfigureShared(int threads, bool pinThreads)
+{
+    sharedThreads = threads;
+    sharedPinThreads = pinThreads;
+}
+
+int SchedulerThreadCount(const Scheduler *scheduler)
+{
+    return scheduler->threads;
+}
+
+int SchedulerWorkerIndex(const Scheduler *scheduler)
+{
+    return currentScheduler == scheduler ? currentWorker : -1;
+}
+
+void SchedulerSpawn(Scheduler *scheduler, TaskGroup *group, Task *task, void (*run)(void *arg), void *arg)
+{
+    task->run = run;
+    task->arg = arg;
+    task->group = group;
+    task->next = NULL;
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+
+    int self = SchedulerWorkerIndex(scheduler);
+    if (self >= 0) {
+        if (!DequePush(&scheduler->deques[self], task)) RunTask(scheduler, task);
+    } else {
+        pthread_mutex_lock(&scheduler->lock);
+        if (scheduler->injectedTail != NULL) scheduler->injectedTail->next = task;
+        else scheduler->injectedHead = task;
+        scheduler->injectedTail = task;
+        atomic_fetch_add(&scheduler->injected, 1);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+
+    atomic_fetch_add(&scheduler->epoch, 1);
+    if (atomic_load(&scheduler->sleepers) > 0) {
+        pthread_mutex_lock(&scheduler->lock);
+        pthread_cond_signal(&scheduler->wake);
+        pthread_mutex_unlock(&scheduler->lock);
+    }
+}
+
+void SchedulerWait(Scheduler *scheduler, TaskGroup *group)
+{
+    int self = SchedulerWorkerIndex(scheduler);
+    if (self < 0) {
+        pthread_mutex_lock(&scheduler->lock);
+        while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+            pthread_cond_wait(&scheduler->joined, &scheduler->lock);
+        }
+        pthread_mutex_unlock(&scheduler->lock);
+        return;
+    }
+
+    // A worker helps out instead of blocking, which also keeps nested joins from deadlocking
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        Task *task = FindTask(scheduler, self);
+        if (task != NULL) RunTask(scheduler, task);
+        else ThreadYield();
+    }
+}
+
+typedef struct {
+    Scheduler *scheduler;
+    void (*body)(void *context, long long begin, long long end);
+    void *context;
+    long long begin;
+    long long end;
+    long long grain;
+} Range;
+
+// Splits off the upper half as a task until the rest is small enough to run here
+static void RunRange(void *arg)
+{
+    Range *range = arg;
+    if (range->end - range->begin <= range->grain) {
+        range->body(range->context, range->begin, range->end);
+        return;
+    }
+
+    long long middle = range->begin + (range->end - range->begin) / 2;
+    Range upper = *range;
+    upper.begin = middle;
+    Range lower = *range;
+    lower.end = middle;
+
+    TaskGroup group;
+    Task task;
+    TaskGroupInit(&group);
+    SchedulerSpawn(range->scheduler, &group, &task, RunRange, &upper);
+    RunRange(&lower);
+    SchedulerWait(range->scheduler, &group);
+}
+
+void SchedulerParallelFor(Scheduler *scheduler, long long count, long long grain,
+                          void (*body)(void *context, long long begin, long long end), void *context)
+{
+    if (count <= 0) return;
+    Range range = {scheduler, body, context, 0, count, grain > 0 ? grain : 1};
+
+    TaskGroup group;
+    Task task;
+    TaskGroupInit(&group);
+    SchedulerSpawn(scheduler, &group, &task, RunRange, &range);
+    SchedulerWait(scheduler, &group);
+}
@@ -0,0 +1,61 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Work-stealing task scheduler that everything running in parallel (the
+// arena, batch evaluation, the game server) submits to, so mixed workloads
+// share one set of threads instead of each starting its own.
+//
+// Every worker owns a deque (Chase-Lev): it pushes and pops its own tasks at
+// the bottom, and a worker that runs dry steals from the top of another's.
+// Tasks spawned from outside the pool go through a shared injection queue.
+// Fork/join uses task groups: spawn tasks into a group, then wait on it. A
+// worker that waits keeps running tasks in the meantime; any other thread
+// sleeps until the group is done.
+
+#define SCHEDULER_DEQUE_SIZE 4096   // per worker; a spawn into a full deque runs inline
+#define SCHEDULER_MAX_THREADS 256
+#define SCHEDULER_SPINS 64          // empty scans before an idle worker sleeps
+
+typedef struct Scheduler Scheduler;
+
+typedef struct {
+    atomic_int pending;
+} TaskGroup;
+
+typedef struct Task {
+    void (*run)(void *arg);
+    void *arg;
+    TaskGroup *group;
+    struct Task *next;      // links the injection queue
+} Task;
+
+// threads <= 0 means one per core; pinned workers stay on core (index % cores)
+Scheduler *SchedulerCreate(int threads, bool pinThreads);
+void SchedulerDestroy(Scheduler *scheduler);
+
+// The process-wide scheduler, started on first use. Configuring it only
+// has an effect before then.
+Scheduler *SchedulerShared(void);
+void SchedulerConfigureShared(int threads, bool pinThreads);
+
+int SchedulerThreadCount(const Scheduler *scheduler);
+
+// Index of the calling worker thread, for per-worker state; -1 on any other
+// thread. Tasks always run on worker threads.
+int SchedulerWorkerIndex(const Scheduler *scheduler);
+
+static inline void TaskGroupInit(TaskGroup *group) { atomic_init(&group->pending, 0); }
+
+// The task must stay valid until the group has been waited on
+void SchedulerSpawn(Scheduler *scheduler, TaskGroup *group, Task *task, void (*run)(void *arg), void *arg);
+void SchedulerWait(Scheduler *scheduler, TaskGroup *group);
+
+// Calls body on pieces of [0, count) no bigger than grain, split recursively
+// across the workers, and returns once all of them are done
+void SchedulerParallelFor(Scheduler *scheduler, long long count, long long grain,
+                          void (*body)(void *context, long long begin, long long end), void *context);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,230 @@
+#include "search.h"
+#include "platform.h"
+#include "trace.h"
+#include <stdlib.h>
+
+#define STOP_CHECK_NODES 1024 // the clock is read once per this many nodes
+
+enum { TT_EXACT = 1, TT_LOWER, TT_UPPER };
+
+Search *SearchCreate(int ttBits)
+{
+    Search *search = calloc(1, sizeof(Search));
+    if (search == NULL) return NULL;
+
+    search->table = calloc((size_t)1 << ttBits, sizeof(TTEntry));
+    if (search->table == NULL) {
+        free(search);
+        return NULL;
+    }
+    search->mask = ((size_t)1 << ttBits) - 1;
+    search->aspirationWindow = SEARCH_ASPIRATION_WINDOW;
+    search->useEvaluation = true;
+    return search;
+}
+
+void SearchDestroy(Search *search)
+{
+    if (search == NULL) return;
+    free(search->table);
+    free(search);
+}
+
+void SearchClear(Search *search)
+{
+    memset(search->table, 0, (search->mask + 1) * sizeof(TTEntry));
+}
+
+// Win scores are stored relative to the node so they stay valid at any ply
+static int ScoreToTable(int score, int ply)
+{
+    if (SearchIsWin(score)) return score + ply;
+    if (SearchIsLoss(score)) return score - ply;
+    return score;
+}
+
+static int ScoreFromTable(int score, int ply)
+{
+    if (SearchIsWin(score)) return score - ply;
+    if (SearchIsLoss(score)) return score + ply;
+    return score;
+}
+
+static void StoreEntry(Search *search, uint64_t key, int depth, int flag, int score, int move, int ply)
+{
+    TTEntry *entry = &search->table[key & search->mask];
+    // Keep deeper results for the same position, anything else is replaced
+    if (entry->key == key && entry->depth > depth) return;
+
+    entry->key = key;
+    entry->depth = (unsigned char)depth;
+    entry->flag = (unsigned char)flag;
+    entry->score = (short)ScoreToTable(score, ply);
+    entry->move = (short)move;
+}
+
+static bool ShouldStop(Search *search)
+{
+    if (search->aborted) return true;
+    if ((search->stop != NULL && atomic_load_explicit(search->stop, memory_order_relaxed)) ||
+        (search->deadline != 0 && TimerNowNs() > search->deadline)) {
+        search->aborted = true;
+    }
+    return search->aborted;
+}
+
+static int Negamax(Search *search, Board *board, int depth, int ply, int alpha, int beta)
+{
+    search->pvLength[ply] = 0;
+    search->nodes++;
+    if ((search->nodes % STOP_CHECK_NODES) == 0 && ShouldStop(search)) return 0;
+
+    // The previous move may have ended the game
+    Cell player = BoardSideToMove(board);
+    if (BoardHasLine(board, Opponent(player))) return -(SEARCH_WIN - ply);
+    if (BoardIsDrawn(board)) return 0;
+    if (depth == 0) return search->useEvaluation ? EvaluatePosition(board, player) : 0;
+
+    uint64_t key = BoardHash(board);
+    const TTEntry *entry = &search->table[key & search->mask];
+    int ttMove = -1;
+    if (entry->key == key && entry->flag != 0) {
+        search->ttHits++;
+        ttMove = entry->move;
+        if (ply > 0 && entry->depth >= depth) {
+            int score = ScoreFromTable(entry->score, ply);
+            if (entry->flag == TT_EXACT) return score;
+            if (entry->flag == TT_LOWER && score >= beta) return score;
+            if (entry->flag == TT_UPPER && score <= alpha) return score;
+        }
+    }
+
+    unsigned short moves[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(board, moves);
+
+    // The table's best move (the previous iteration's PV along the PV) goes first
+    for (int i = 1; i < count && ttMove >= 0; i++) {
+        if (moves[i] == ttMove) {
+            moves[i] = moves[0];
+            moves[0] = (unsigned short)ttMove;
+            break;
+        }
+    }
+
+    int originalAlpha = alpha;
+    int bestScore = -SEARCH_INFINITY;
+    int bestMove = moves[0];
+
+    for (int i = 0; i < count; i++) {
+        int score;
+        BoardMakeMove(board, moves[i], player);
+        if (i == 0) {
+            score = -Negamax(search, board, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // Null-window probe, re-searched only if the move might be better
+            score = -Negamax(search, board, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) {
+                score = -Negamax(search, board, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        BoardUnmakeMove(board);
+        if (search->aborted) return 0; // scores from an unfinished subtree mean nothing
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = moves[i];
+        }
+        if (score > alpha) {
+            alpha = score;
+            search->pv[ply][0] = moves[i];
+            memcpy(&search->pv[ply][1], search->pv[ply + 1], search->pvLength[ply + 1] * sizeof(unsigned short));
+            search->pvLength[ply] = (unsigned char)(search->pvLength[ply + 1] + 1);
+        }
+        if (alpha >= beta) break;
+    }
+
+    int flag = bestScore <= originalAlpha ? TT_UPPER : bestScore >= beta ? TT_LOWER : TT_EXACT;
+    StoreEntry(search, key, depth, flag, bestScore, bestMove, ply);
+    return bestScore;
+}
+
+// Table cutoffs cut the triangular PV short, so finish it from the stored best moves
+static void ExtendPv(Search *search, Board *board, SearchResult *result)
+{
+    int played = 0;
+    for (int i = 0; i < result->pvLength; i++) {
+        BoardMakeMove(board, result->pv[i], BoardSideToMove(board));
+        played++;
+    }
+
+    while (result->pvLength < SEARCH_MAX_PLY && !BoardIsDrawn(board) &&
+           !BoardHasLine(board, PLAYER_X) && !BoardHasLine(board, PLAYER_O)) {
+        uint64_t key = BoardHash(board);
+        const TTEntry *entry = &search->table[key & search->mask];
+        if (entry->key != key || entry->flag != TT_EXACT || entry->move < 0) break;
+        if (BoardGetCell(board, entry->move) != EMPTY) break;
+
+        result->pv[result->pvLength++] = (unsigned short)entry->move;
+        BoardMakeMove(board, entry->move, BoardSideToMove(board));
+        played++;
+    }
+
+    while (played-- > 0) BoardUnmakeMove(board);
+}
+
+bool SearchRun(Search *search, Board *board, int maxDepth, SearchResult *result)
+{
+    int empty = BoardEmptyCount(board);
+    if (maxDepth > empty) maxDepth = empty;
+
+    memset(result, 0, sizeof(*result));
+    result->move = -1;
+    search->nodes = 0;
+    search->ttHits = 0;
+    search->aborted = false;
+    TRACE_BEGIN("SearchRun");
+
+    int previousScore = 0;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int window = search->aspirationWindow;
+        int alpha = (depth > 1 && window > 0) ? previousScore - window : -SEARCH_INFINITY;
+        int beta = (depth > 1 && window > 0) ? previousScore + window : SEARCH_INFINITY;
+        int score;
+
+        // Aspiration window: a result outside it is re-searched with that side opened up
+        for (;;) {
+            score = Negamax(search, board, depth, 0, alpha, beta);
+            if (search->aborted) break;
+            if (score <= alpha && alpha > -SEARCH_INFINITY) alpha = -SEARCH_INFINITY;
+            else if (score >= beta && beta < SEARCH_INFINITY) beta = SEARCH_INFINITY;
+            else break;
+        }
+        if (search->aborted) break;
+
+        previousScore = score;
+        result->score = score;
+        result->depth = depth;
+        result->pvLength = search->pvLength[0];
+        memcpy(result->pv, search->pv[0], result->pvLength * sizeof(unsigned short));
+        ExtendPv(search, board, result);
+        if (result->pvLength > 0) result->move = result->pv[0];
+        result->nodes = search->nodes;
+        if (search->progress != NULL) search->progress(result, search->progressContext);
+        TRACE_COUNTER("search nodes", search->nodes);
+        TRACE_COUNTER("tt hits", search->ttHits);
+
+        // A forced result needs no deeper search
+        if (SearchIsWin(score) || SearchIsLoss(score)) break;
+    }
+
+    // Stopped inside the first iteration: the best root move searched so far still beats none
+    if (result->move == -1 && search->pvLength[0] > 0) {
+        result->move = search->pv[0][0];
+        result->pvLength = 1;
+        result->pv[0] = (unsigned short)result->move;
+    }
+
+    result->nodes = search->nodes;
+    TRACE_END("SearchRun");
+    return result->move != -1;
+}
@@ -0,0 +1,72 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "board.h"
+#include "eval.h"
+#include <stdatomic.h>
+
+// Negamax alpha-beta search with principal variation search (null-window
+// probes after the first move), aspiration windows around the previous
+// iteration's score and a transposition table keyed by the Zobrist hash.
+// Scores are from the side to move's point of view: a win found at ply p is
+// worth SEARCH_WIN - p, so quicker wins and slower losses score higher.
+// Positions cut off by the depth limit get the static evaluation, which
+// never reaches the win scores.
+//
+// A search can be given a deadline and a stop flag another thread may raise;
+// it then returns the last completed iteration (or the best root move so far
+// if not even the first one finished).
+
+#define SEARCH_WIN 1000
+#define SEARCH_INFINITY 10000
+#define SEARCH_MAX_PLY BOARD_MAX_CELLS
+#define SEARCH_DEFAULT_TT_BITS 16
+#define SEARCH_ASPIRATION_WINDOW 16
+
+typedef struct {
+    uint64_t key;
+    short score;
+    short move;
+    unsigned char depth;
+    unsigned char flag;
+} TTEntry;
+
+typedef struct {
+    int move;
+    int score;
+    int depth;       // deepest completed iteration
+    long long nodes;
+    int pvLength;
+    unsigned short pv[SEARCH_MAX_PLY];
+} SearchResult;
+
+// Called after every completed iteration, e.g. to stream progress
+typedef void (*SearchProgress)(const SearchResult *result, void *context);
+
+typedef struct {
+    TTEntry *table;
+    size_t mask;
+    int aspirationWindow;
+    bool useEvaluation;  // score the depth limit with EvaluatePosition instead of as a draw
+    uint64_t deadline;           // TimerNowNs() to stop at, 0 = no time limit
+    const atomic_bool *stop;     // may be NULL
+    bool aborted;
+    SearchProgress progress;     // may be NULL
+    void *progressContext;
+    long long nodes;
+    long long ttHits;            // probes that found this position in the table
+    unsigned char pvLength[SEARCH_MAX_PLY + 1];
+    unsigned short pv[SEARCH_MAX_PLY + 1][SEARCH_MAX_PLY + 1]; // triangular PV table
+} Search;
+
+Search *SearchCreate(int ttBits);
+void SearchDestroy(Search *search);
+void SearchClear(Search *search);
+
+// Iterative deepening up to maxDepth plies; the board is left unchanged
+bool SearchRun(Search *search, Board *board, int maxDepth, SearchResult *result);
+
+static inline bool SearchIsWin(int score) { return score > SEARCH_WIN - SEARCH_MAX_PLY - 1; }
+static inline bool SearchIsLoss(int score) { return score < -(SEARCH_WIN - SEARCH_MAX_PLY - 1); }
+
+#endif // SEARCH_H
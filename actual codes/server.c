@@ -0,0 +1,772 @@
+#include "server.h"
+#include "platform.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LISTEN_TAG UINT32_MAX       // epoll tags for the two fds that aren't connections
+#define WAKE_TAG (UINT32_MAX - 1)
+#define MAX_EVENTS 256
+#define INPUT_BUFFER 4096
+
+struct Server;
+
+typedef struct {
+    Board board;
+    Task task;          // the engine move, while thinking
+    struct Server *server;
+    Cell engineSide;
+    int connection;     // owner, -1 once it has gone away
+    int next;           // free list
+    bool inUse;
+    bool thinking;      // a worker has the board
+    uint64_t queuedAt;
+    uint64_t startedAt;
+} ServerGame;
+
+typedef struct {
+    int game;
+    int move;
+} Completion;
+
+typedef struct {
+    int fd;             // -1 when the slot is free
+    int next;           // free list
+    char input[INPUT_BUFFER];
+    int inputLength;
+    char *output;
+    size_t outputLength;
+    size_t outputCapacity;
+    bool waitingToWrite;
+} Connection;
+
+typedef struct Server {
+    const ServerConfig *config;
+    ServerStats *stats;
+    Scheduler *scheduler;
+    Engine *engines;    // one per scheduler worker
+    int epollFd;
+    int listenFd;
+    int wakeFd;
+    bool running;
+
+    ServerGame *games;
+    int freeGames;
+    int usedGames;      // high-water mark of the pool
+    Connection *connections;
+    int freeConnections;
+
+    // Bounded by the game pool, as each game has at most one engine move outstanding
+    TaskGroup thinking;
+    pthread_mutex_t lock;
+    Completion *completions;
+    int completionCount;
+} Server;
+
+static void SetNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// Scheduler task: nothing else touches a thinking game's board
+static void ThinkTask(void *arg)
+{
+    ServerGame *game = arg;
+    Server *server = game->server;
+    Engine *engine = &server->engines[SchedulerWorkerIndex(server->scheduler)];
+    int move = EngineChooseMove(engine, &game->board);
+
+    pthread_mutex_lock(&server->lock);
+    server->completions[server->completionCount++] = (Completion){(int)(game - server->games), move};
+    pthread_mutex_unlock(&server->lock);
+    uint64_t one = 1;
+    if (write(server->wakeFd, &one, sizeof(one)) < 0) {
+        // The counter only overflows if the loop stopped reading, and then nobody is waiting
+    }
+}
+
+static bool Flush(Server *server, int index)
+{
+    Connection *connection = &server->connections[index];
+    size_t sent = 0;
+    while (sent < connection->outputLength) {
+        ssize_t written = send(connection->fd, connection->output + sent, connection->outputLength - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        sent += (size_t)written;
+    }
+    memmove(connection->output, connection->output + sent, connection->outputLength - sent);
+    connection->outputLength -= sent;
+
+    // Only ask for writability while there is something left to write
+    bool waiting = connection->outputLength > 0;
+    if (waiting != connection->waitingToWrite) {
+        struct epoll_event event = {.events = EPOLLIN | (waiting ? EPOLLOUT : 0), .data.u32 = (uint32_t)index};
+        epoll_ctl(server->epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->waitingToWrite = waiting;
+    }
+    return true;
+}
+
+static void Reply(Server *server, int index, const char *format, ...)
+{
+    Connection *connection = &server->connections[index];
+    char line[SERVER_MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (length < 0) return;
+    if (length > (int)sizeof(line) - 2) length = (int)sizeof(line) - 2;
+    line[length++] = '\n';
+
+    if (connection->outputLength + (size_t)length > connection->outputCapacity) {
+        size_t capacity = connection->outputCapacity ? connection->outputCapacity * 2 : 4096;
+        while (capacity < connection->outputLength + (size_t)length) capacity *= 2;
+        char *output = realloc(connection->output, capacity);
+        if (output == NULL) return;
+        connection->output = output;
+        connection->outputCapacity = capacity;
+    }
+    memcpy(connection->output + connection->outputLength, line, (size_t)length);
+    connection->outputLength += (size_t)length;
+}
+
+static int AllocGame(Server *server)
+{
+    int index;
+    if (server->freeGames != -1) {
+        index = server->freeGames;
+        server->freeGames = server->games[index].next;
+    } else if (server->usedGames < server->config->maxGames) {
+        index = server->usedGames++;
+    } else {
+        return -1;
+    }
+    server->games[index].inUse = true;
+    server->games[index].thinking = false;
+    return index;
+}
+
+static void FreeGame(Server *server, int index)
+{
+    server->games[index].inUse = false;
+    server->games[index].next = server->freeGames;
+    server->freeGames = index;
+}
+
+static void QueueEngineMove(Server *server, int index)
+{
+    ServerGame *game = &server->games[index];
+    game->thinking = true;
+    game->queuedAt = TimerNowNs();
+    game->server = server;
+    SchedulerSpawn(server->scheduler, &server->thinking, &game->task, ThinkTask, game);
+}
+
+static void SaveGame(Server *server, const ServerGame *game)
+{
+    const EngineConfig *engine = &server->config->engine;
+    int mode = engine->difficulty | (engine->type == ENGINE_MCTS ? GAME_MCTS : 0) | (game->engineSide == PLAYER_X ? GAME_AI_X : 0);
+    GameRecord record = GameRecordFromBoard(&game->board, mode, (uint32_t)((TimerNowNs() - game->startedAt) / 1000000000ULL),
+                                            (uint32_t)time(NULL));
+    GameDbAppend(server->config->games, &record);
+}
+
+// Ends the game if the move just played decided it, true if it did
+static bool CheckFinished(Server *server, int index, int move, Cell player)
+{
+    ServerGame *game = &server->games[index];
+    const char *result = NULL;
+    StatsResult engineResult = STATS_DRAW;
+    if (BoardCompletesLine(&game->board, move, player)) {
+        result = player == PLAYER_X ? "x" : "o";
+        engineResult = player == game->engineSide ? STATS_WIN : STATS_LOSS;
+    } else if (BoardIsDrawn(&game->board)) {
+        result = "draw";
+    }
+    if (result == NULL) return false;
+
+    if (server->config->recordStats) StatsStoreRecord(server->config->engine.difficulty, engineResult);
+    if (server->config->games != NULL) SaveGame(server, game);
+
+    if (game->connection != -1) Reply(server, game->connection, "end %d %s", index, result);
+    server->stats->gamesFinished++;
+    FreeGame(server, index);
+    return true;
+}
+
+static void NewGame(Server *server, int connection, const char *side)
+{
+    int index = AllocGame(server);
+    if (index == -1) {
+        Reply(server, connection, "error full");
+        return;
+    }
+
+    ServerGame *game = &server->games[index];
+    BoardInit(&game->board, server->config->geo);
+    game->engineSide = (side[0] == 'o' || side[0] == 'O') ? PLAYER_X : PLAYER_O;
+    game->connection = connection;
+    game->startedAt = TimerNowNs();
+    server->stats->gamesStarted++;
+
+    Reply(server, connection, "game %d %d %d", index, server->config->geo->size, server->config->geo->winLength);
+    if (game->engineSide == PLAYER_X) QueueEngineMove(server, index);
+}
+
+static void PlayMove(Server *server, int connection, int index, int move)
+{
+    if (index < 0 || index >= server->usedGames || !server->games[index].inUse ||
+        server->games[index].connection != connection) {
+        Reply(server, connection, "error no game %d", index);
+        return;
+    }
+
+    ServerGame *game = &server->games[index];
+    Cell player = BoardSideToMove(&game->board);
+    if (game->thinking || player == game->engineSide) {
+        Reply(server, connection, "error not your turn in game %d", index);
+        return;
+    }
+    if (move < 0 || move >= game->board.geo->cellCount || BoardGetCell(&game->board, move) != EMPTY) {
+        Reply(server, connection, "error illegal move %d in game %d", move, index);
+        return;
+    }
+
+    BoardMakeMove(&game->board, move, player);
+    if (!CheckFinished(server, index, move, player)) QueueEngineMove(server, index);
+}
+
+static void CloseConnection(Server *server, int index)
+{
+    Connection *connection = &server->connections[index];
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->fd = -1;
+    free(connection->output);
+    connection->output = NULL;
+    connection->outputLength = connection->outputCapacity = 0;
+    connection->next = server->freeConnections;
+    server->freeConnections = index;
+
+    // Games a worker still has are freed when their move comes back
+    for (int i = 0; i < server->usedGames; i++) {
+        ServerGame *game = &server->games[i];
+        if (!game->inUse || game->connection != index) continue;
+        game->connection = -1;
+        if (!game->thinking) FreeGame(server, i);
+    }
+}
+
+static void HandleLine(Server *server, int connection, char *line)
+{
+    char command[16], side[8] = "x";
+    int index, move;
+    if (sscanf(line, "%15s", command) != 1) return;
+
+    if (strcmp(command, "new") == 0) {
+        sscanf(line, "%*s %7s", side);
+        NewGame(server, connection, side);
+    } else if (strcmp(command, "move") == 0 && sscanf(line, "%*s %d %d", &index, &move) == 2) {
+        PlayMove(server, connection, index, move);
+    } else if (strcmp(command, "shutdown") == 0) {
+        server->running = false;
+    } else {
+        Reply(server, connection, "error unknown command %s", command);
+    }
+}
+
+static void ReadConnection(Server *server, int index)
+{
+    Connection *connection = &server->connections[index];
+    for (;;) {
+        ssize_t received = recv(connection->fd, connection->input + connection->inputLength,
+                                sizeof(connection->input) - 1 - (size_t)connection->inputLength, 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            CloseConnection(server, index);
+            return;
+        }
+        if (received < 0) break;
+        connection->inputLength += (int)received;
+        connection->input[connection->inputLength] = '\0';
+
+        char *start = connection->input;
+        char *end;
+        while ((end = strchr(start, '\n')) != NULL) {
+            *end = '\0';
+            if (strncmp(start, "quit", 4) == 0) {
+                CloseConnection(server, index);
+                return;
+            }
+            HandleLine(server, index, start);
+            start = end + 1;
+        }
+
+        // Keep the partial line; one that fills the whole buffer is dropped
+        connection->inputLength -= (int)(start - connection->input);
+        if (connection->inputLength >= (int)sizeof(connection->input) - 1) connection->inputLength = 0;
+        memmove(connection->input, start, (size_t)connection->inputLength);
+    }
+    if (!Flush(server, index)) CloseConnection(server, index);
+}
+
+static void AcceptConnections(Server *server)
+{
+    for (;;) {
+        int fd = accept(server->listenFd, NULL, NULL);
+        if (fd < 0) return;
+        if (server->freeConnections == -1) {
+            close(fd);
+            continue;
+        }
+
+        int index = server->freeConnections;
+        Connection *connection = &server->connections[index];
+        server->freeConnections = connection->next;
+        connection->fd = fd;
+        connection->inputLength = 0;
+        connection->waitingToWrite = false;
+        SetNonBlocking(fd);
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = (uint32_t)index};
+        epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+static void HandleCompletions(Server *server, Completion *batch)
+{
+    uint64_t count;
+    if (read(server->wakeFd, &count, sizeof(count)) < 0) return;
+
+    pthread_mutex_lock(&server->lock);
+    int completed = server->completionCount;
+    memcpy(batch, server->completions, sizeof(Completion) * (size_t)completed);
+    server->completionCount = 0;
+    pthread_mutex_unlock(&server->lock);
+
+    uint64_t now = TimerNowNs();
+    for (int i = 0; i < completed; i++) {
+        int index = batch[i].game;
+        ServerGame *game = &server->games[index];
+        game->thinking = false;
+        server->stats->engineMoves++;
+        LatencyRecord(&server->stats->moveLatency, now - game->queuedAt);
+
+        if (game->connection == -1) {
+            FreeGame(server, index);
+            continue;
+        }
+        int connection = game->connection;
+        if (batch[i].move < 0) {
+            Reply(server, connection, "end %d draw", index);
+            if (server->config->recordStats) StatsStoreRecord(server->config->engine.difficulty, STATS_DRAW);
+            if (server->config->games != NULL) SaveGame(server, game);
+            server->stats->gamesFinished++;
+            FreeGame(server, index);
+        } else {
+            BoardMakeMove(&game->board, batch[i].move, game->engineSide);
+            Reply(server, connection, "move %d %d", index, batch[i].move);
+            CheckFinished(server, index, batch[i].move, game->engineSide);
+        }
+        if (!Flush(server, connection)) CloseConnection(server, connection);
+    }
+}
+
+static int OpenListener(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    SetNonBlocking(fd);
+    return fd;
+}
+
+bool ServerRun(const ServerConfig *config, ServerStats *stats)
+{
+    Server server;
+    memset(&server, 0, sizeof(server));
+    memset(stats, 0, sizeof(*stats));
+    server.config = config;
+    server.stats = stats;
+    server.scheduler = config->scheduler != NULL ? config->scheduler : SchedulerShared();
+    server.freeGames = -1;
+    server.games = calloc((size_t)config->maxGames, sizeof(ServerGame));
+    server.connections = calloc(SERVER_MAX_CONNECTIONS, sizeof(Connection));
+    server.completions = calloc((size_t)config->maxGames, sizeof(Completion));
+    Completion *batch = calloc((size_t)config->maxGames, sizeof(Completion));
+    server.listenFd = OpenListener(config->socketPath);
+    server.epollFd = epoll_create1(0);
+    server.wakeFd = eventfd(0, EFD_NONBLOCK);
+    TaskGroupInit(&server.thinking);
+    pthread_mutex_init(&server.lock, NULL);
+
+    int threads = server.scheduler != NULL ? SchedulerThreadCount(server.scheduler) : 0;
+    server.engines = threads > 0 ? calloc((size_t)threads, sizeof(Engine)) : NULL;
+    for (int i = 0; server.engines != NULL && i < threads; i++) {
+        EngineInit(&server.engines[i], &config->engine, config->tablebase, TimerNowNs() + (uint64_t)i);
+    }
+
+    bool ok = server.engines != NULL && server.games != NULL && server.connections != NULL && server.completions != NULL &&
+              batch != NULL && server.listenFd >= 0 && server.epollFd >= 0 && server.wakeFd >= 0;
+    if (ok) {
+        for (int i = 0; i < SERVER_MAX_CONNECTIONS; i++) {
+            server.connections[i].fd = -1;
+            server.connections[i].next = i + 1 < SERVER_MAX_CONNECTIONS ? i + 1 : -1;
+        }
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = LISTEN_TAG};
+        epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event);
+        event.data.u32 = WAKE_TAG;
+        epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.wakeFd, &event);
+    }
+
+    uint64_t start = TimerNowNs();
+    server.running = ok;
+    struct epoll_event events[MAX_EVENTS];
+    while (server.running) {
+        int ready = epoll_wait(server.epollFd, events, MAX_EVENTS, -1);
+        if (ready < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < ready; i++) {
+            uint32_t tag = events[i].data.u32;
+            if (tag == LISTEN_TAG) {
+                AcceptConnections(&server);
+            } else if (tag == WAKE_TAG) {
+                HandleCompletions(&server, batch);
+            } else if (server.connections[tag].fd != -1) {
+                // Skip events for a connection closed earlier in this batch
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) ReadConnection(&server, (int)tag);
+                if (server.connections[tag].fd != -1 && (events[i].events & EPOLLOUT) && !Flush(&server, (int)tag)) {
+                    CloseConnection(&server, (int)tag);
+                }
+            }
+        }
+    }
+    stats->seconds = (double)(TimerNowNs() - start) / 1e9;
+
+    // Moves still being thought about hold pointers into the pools
+    if (server.scheduler != NULL) SchedulerWait(server.scheduler, &server.thinking);
+    for (int i = 0; server.engines != NULL && i < threads; i++) EngineFree(&server.engines[i]);
+
+    for (int i = 0; server.connections != NULL && i < SERVER_MAX_CONNECTIONS; i++) {
+        if (server.connections[i].fd != -1) CloseConnection(&server, i);
+    }
+    if (server.listenFd >= 0) {
+        close(server.listenFd);
+        unlink(config->socketPath);
+    }
+    if (server.epollFd >= 0) close(server.epollFd);
+    if (server.wakeFd >= 0) close(server.wakeFd);
+    pthread_mutex_destroy(&server.lock);
+    free(server.engines);
+    free(server.games);
+    free(server.connections);
+    free(server.completions);
+    free(batch);
+    return ok;
+}
+
+static void PrintLatency(const char *label, const LatencyHistogram *latency)
+{
+    printf("  %s (us): mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n", label,
+           latency->count ? latency->totalNs / 1000.0 / latency->count : 0.0,
+           LatencyPercentile(latency, 50) / 1000.0, LatencyPercentile(latency, 90) / 1000.0,
+           LatencyPercentile(latency, 99) / 1000.0, latency->maxNs / 1000.0);
+}
+
+int ServerMain(int argc, char **argv, const Tablebase *tablebase)
+{
+    ServerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.socketPath = argc > 0 ? argv[0] : SERVER_DEFAULT_SOCKET;
+    config.geo = BoardGeometryGet(3, 3);
+    config.engine = EngineConfigDefault(ENGINE_MINIMAX, HARD);
+    config.tablebase = tablebase;
+    config.maxGames = SERVER_DEFAULT_GAMES;
+
+    int size, columns, winLength;
+    if ((argc > 1 && (sscanf(argv[1], "%dx%dk%d", &size, &columns, &winLength) != 3 || columns != size ||
+                      (config.geo = BoardGeometryGet(size, winLength)) == NULL)) ||
+        (argc > 2 && !EngineConfigParse(argv[2], &config.engine))) {
+        printf("Usage: [--threads N[:pin]] --server [socket] [NxNkK] [engine]\n");
+        return 1;
+    }
+
+    // Games on the classic board count towards the AI's results in the game, and are kept for --games
+    GameDb games;
+    bool classic = config.geo->size == 3 && config.geo->winLength == 3;
+    config.recordStats = classic && StatsStoreOpen(STATS_DEFAULT_FILE);
+    config.games = classic && GameDbOpen(&games, GAME_DB_DEFAULT_FILE) ? &games : NULL;
+
+    printf("Serving %dx%d k%d games on %s\n", config.geo->size, config.geo->size, config.geo->winLength, config.socketPath);
+    fflush(stdout);
+
+    ServerStats stats;
+    bool served = ServerRun(&config, &stats);
+    StatsStoreClose();
+    if (config.games != NULL) GameDbClose(config.games);
+    if (!served) {
+        printf("Error starting server!\n");
+        return 1;
+    }
+
+    printf("\nServer: %lld games finished in %.2fs (%.0f games/sec), %lld engine moves\n",
+           stats.gamesFinished, stats.seconds, stats.seconds > 0 ? stats.gamesFinished / stats.seconds : 0.0, stats.engineMoves);
+    PrintLatency("Engine move latency", &stats.moveLatency);
+    return 0;
+}
+
+// Load generator: the client always plays X with random moves
+
+typedef enum { SLOT_IDLE, SLOT_STARTING, SLOT_WAITING, SLOT_PLAYING } SlotState;
+
+typedef struct {
+    SlotState state;
+    int id;
+    Board board;
+    uint64_t sentAt;
+} LoadGame;
+
+typedef struct {
+    int fd;
+    LoadGame *games;
+    char input[INPUT_BUFFER];
+    int inputLength;
+} LoadConnection;
+
+typedef struct {
+    long long target;
+    long long started;
+    long long finished;         // refused ones included
+    long long refused;          // turned down with "error full"
+    long long results[3];       // indexed by Cell, EMPTY for draws
+    LatencyHistogram latency;
+    uint64_t rng;
+    int concurrent;
+} LoadGen;
+
+static bool SendLine(int fd, const char *line)
+{
+    size_t length = strlen(line), sent = 0;
+    while (sent < length) {
+        ssize_t written = send(fd, line + sent, length - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno != EAGAIN && errno != EINTR) return false;
+        if (written > 0) sent += (size_t)written;
+    }
+    return true;
+}
+
+static void StartGame(LoadGen *gen, LoadConnection *connection, LoadGame *game)
+{
+    if (gen->started >= gen->target) {
+        game->state = SLOT_IDLE;
+        return;
+    }
+    gen->started++;
+    game->state = SLOT_STARTING;
+    SendLine(connection->fd, "new x\n");
+}
+
+static void PlayRandomMove(LoadGen *gen, LoadConnection *connection, LoadGame *game)
+{
+    unsigned short cells[BOARD_MAX_CELLS];
+    int count = BoardEmptyCells(&game->board, cells);
+    int move = cells[RngRange(&gen->rng, count)];
+    BoardMakeMove(&game->board, move, PLAYER_X);
+
+    char line[64];
+    snprintf(line, sizeof(line), "move %d %d\n", game->id, move);
+    game->state = SLOT_WAITING;
+    game->sentAt = TimerNowNs();
+    SendLine(connection->fd, line);
+}
+
+static LoadGame *FindGame(LoadGen *gen, LoadConnection *connection, SlotState state, int id)
+{
+    for (int i = 0; i < gen->concurrent; i++) {
+        LoadGame *game = &connection->games[i];
+        if (game->state == state && (state == SLOT_STARTING || game->id == id)) return game;
+    }
+    return NULL;
+}
+
+static void HandleReply(LoadGen *gen, LoadConnection *connection, const char *line)
+{
+    int id, a, b;
+    char result[8];
+    LoadGame *game;
+
+    if (sscanf(line, "game %d %d %d", &id, &a, &b) == 3 && (game = FindGame(gen, connection, SLOT_STARTING, 0)) != NULL) {
+        const BoardGeometry *geo = BoardGeometryGet(a, b);
+        if (geo == NULL) return;
+        BoardInit(&game->board, geo);
+        game->id = id;
+        PlayRandomMove(gen, connection, game);
+    } else if (sscanf(line, "move %d %d", &id, &a) == 2 && (game = FindGame(gen, connection, SLOT_WAITING, id)) != NULL) {
+        LatencyRecord(&gen->latency, TimerNowNs() - game->sentAt);
+        BoardMakeMove(&game->board, a, PLAYER_O);
+        game->state = SLOT_PLAYING;
+        if (!BoardCompletesLine(&game->board, a, PLAYER_O) && !BoardIsDrawn(&game->board)) {
+            PlayRandomMove(gen, connection, game);
+        }
+    } else if (sscanf(line, "end %d %7s", &id, result) == 2) {
+        game = FindGame(gen, connection, SLOT_WAITING, id);
+        if (game != NULL) LatencyRecord(&gen->latency, TimerNowNs() - game->sentAt);
+        else game = FindGame(gen, connection, SLOT_PLAYING, id);
+        if (game == NULL) return;
+
+        gen->results[result[0] == 'x' ? PLAYER_X : result[0] == 'o' ? PLAYER_O : EMPTY]++;
+        gen->finished++;
+        StartGame(gen, connection, game);
+    } else if (strcmp(line, "error full") == 0 && (game = FindGame(gen, connection, SLOT_STARTING, 0)) != NULL) {
+        // The server's games are all taken; this slot gives up rather than asking again
+        gen->refused++;
+        gen->finished++;
+        game->state = SLOT_IDLE;
+    } else {
+        printf("Server: %s\n", line);
+    }
+}
+
+static int ConnectTo(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int LoadGenMain(int argc, char **argv)
+{
+    const char *path = argc > 0 ? argv[0] : SERVER_DEFAULT_SOCKET;
+    LoadGen gen;
+    memset(&gen, 0, sizeof(gen));
+    gen.target = argc > 1 ? atoll(argv[1]) : 10000;
+    int connections = argc > 2 ? atoi(argv[2]) : 4;
+    gen.concurrent = argc > 3 ? atoi(argv[3]) : 16;
+    gen.rng = RngSeed(TimerNowNs());
+    if (gen.target <= 0 || connections <= 0 || gen.concurrent <= 0) {
+        printf("Usage: --loadgen [socket] [games] [connections] [concurrent]\n");
+        return 1;
+    }
+
+    LoadConnection *clients = calloc((size_t)connections, sizeof(LoadConnection));
+    int epollFd = epoll_create1(0);
+    bool ok = clients != NULL && epollFd >= 0;
+    for (int i = 0; ok && i < connections; i++) clients[i].fd = -1;
+    for (int i = 0; ok && i < connections; i++) {
+        clients[i].games = calloc((size_t)gen.concurrent, sizeof(LoadGame));
+        clients[i].fd = ConnectTo(path);
+        if (clients[i].games == NULL || clients[i].fd < 0) {
+            ok = false;
+            break;
+        }
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = (uint32_t)i};
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].fd, &event);
+    }
+    if (!ok) printf("Error connecting to %s!\n", path);
+
+    uint64_t start = TimerNowNs();
+    for (int i = 0; ok && i < connections; i++) {
+        for (int g = 0; g < gen.concurrent; g++) StartGame(&gen, &clients[i], &clients[i].games[g]);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (ok && gen.finished < gen.started) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (ready < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < ready; i++) {
+            LoadConnection *connection = &clients[events[i].data.u32];
+            ssize_t received = recv(connection->fd, connection->input + connection->inputLength,
+                                    sizeof(connection->input) - 1 - (size_t)connection->inputLength, 0);
+            if (received <= 0) {
+                printf("Server closed the connection!\n");
+                ok = false;
+                break;
+            }
+            connection->inputLength += (int)received;
+            connection->input[connection->inputLength] = '\0';
+
+            char *lineStart = connection->input;
+            char *end;
+            while ((end = strchr(lineStart, '\n')) != NULL) {
+                *end = '\0';
+                HandleReply(&gen, connection, lineStart);
+                lineStart = end + 1;
+            }
+            connection->inputLength -= (int)(lineStart - connection->input);
+            memmove(connection->input, lineStart, (size_t)connection->inputLength);
+        }
+    }
+    double seconds = (double)(TimerNowNs() - start) / 1e9;
+
+    for (int i = 0; clients != NULL && i < connections; i++) {
+        if (clients[i].fd >= 0) close(clients[i].fd);
+        free(clients[i].games);
+    }
+    free(clients);
+    if (epollFd >= 0) close(epollFd);
+    if (!ok) return 1;
+
+    long long played = gen.finished - gen.refused;
+    printf("\nLoad: %lld games in %.2fs (%.0f games/sec) over %d connections, %d games each at a time\n",
+           played, seconds, seconds > 0 ? played / seconds : 0.0, connections, gen.concurrent);
+    if (gen.refused > 0) printf("  Refused by a full server: %lld\n", gen.refused);
+    printf("  Client wins: %lld, Engine wins: %lld, Draws: %lld\n", gen.results[PLAYER_X], gen.results[PLAYER_O], gen.results[EMPTY]);
+    PrintLatency("Move round trip", &gen.latency);
+    return 0;
+}
+
+#else
+
+bool ServerRun(const ServerConfig *config, ServerStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    return false;
+}
+
+int ServerMain(int argc, char **argv, const Tablebase *tablebase)
+{
+    printf("The game server needs epoll and is only available on Linux.\n");
+    return 1;
+}
+
+int LoadGenMain(int argc, char **argv)
+{
+    printf("The load generator needs epoll and is only available on Linux.\n");
+    return 1;
+}
+
+#endif
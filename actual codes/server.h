@@ -0,0 +1,59 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "engine.h"
+#include "game_db.h"
+#include "latency.h"
+#include "scheduler.h"
+#include "stats_store.h"
+
+// Game server: many independent games against the engine in one process,
+// played over a local (Unix domain) socket with a line protocol:
+//   new [x|o]         -> game <id> <size> <winLength>; the side is the
+//                        client's (default x), and if the engine has the
+//                        first move its move line follows
+//   move <id> <cell>  -> move <id> <cell> with the engine's reply
+//   end <id> <x|o|draw>  sent once a game is over, after which the id is free
+//   quit, shutdown
+// One thread runs an epoll loop over every connection. Engine moves are
+// scheduler tasks, with an engine (and its caches) per worker, and come
+// back to the loop through an eventfd. Games live in a fixed pool with a
+// free list, so hosting a game allocates nothing. Linux only; elsewhere
+// the entry points just say so.
+
+#define SERVER_DEFAULT_SOCKET "tictactoe.sock"
+#define SERVER_DEFAULT_GAMES 16384
+#define SERVER_MAX_CONNECTIONS 1024
+#define SERVER_MAX_LINE 256
+
+typedef struct {
+    const char *socketPath;
+    const BoardGeometry *geo;
+    EngineConfig engine;
+    const Tablebase *tablebase;
+    Scheduler *scheduler;   // NULL = the shared one
+    int maxGames;           // games in play at once, over all connections
+    bool recordStats;       // results go to the stats store, which the caller opened
+    GameDb *games;          // finished games are appended here, NULL for none
+} ServerConfig;
+
+typedef struct {
+    long long gamesStarted;
+    long long gamesFinished;
+    long long engineMoves;
+    LatencyHistogram moveLatency;   // queueing plus search, per engine move
+    double seconds;
+} ServerStats;
+
+// Serves until a client sends "shutdown"
+bool ServerRun(const ServerConfig *config, ServerStats *stats);
+
+// Entry point for "--server [socket] [NxNkK] [engine]"
+int ServerMain(int argc, char **argv, const Tablebase *tablebase);
+
+// Entry point for "--loadgen [socket] [games] [connections] [concurrent]":
+// plays random moves against a running server, `concurrent` games at a time
+// on each connection, and reports games/sec and move latency percentiles
+int LoadGenMain(int argc, char **argv);
+
+#endif // SERVER_H
@@ -0,0 +1,246 @@
+#include "stats_store.h"
+#include "mapped_file.h"
+#include "platform.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef int64_t StatsCounts[HARD + 1][STATS_DRAW + 1];
+
+typedef struct {
+    char snapshotPath[STATS_MAX_PATH];
+    char journalPath[STATS_MAX_PATH + 8];
+    bool open;
+
+    // Shared with the writer, under lock
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t writer;
+    bool stopping;
+    StatsCounts totals;         // everything recorded, written or not
+    StatsRecord *pending;
+    size_t pendingCount;
+    size_t pendingCapacity;
+
+    // The writer's own
+    FILE *journal;
+    StatsRecord *writing;
+    size_t writingCapacity;
+    StatsCounts written;        // what the snapshot and journal on disk add up to
+    uint64_t generation;
+    long long journalRecords;
+    bool failed;                // a write went wrong, reported once
+} StatsStore;
+
+static StatsStore store;
+
+static bool RecordValid(const StatsRecord *record)
+{
+    return record->tag == STATS_RECORD_TAG && record->difficulty <= HARD && record->result <= STATS_DRAW;
+}
+
+// Adds up the snapshot and the journal of the same generation. True when
+// the journal can be appended to as it is.
+static bool LoadFiles(void)
+{
+    MappedFile file = {0};
+    if (MappedFileOpen(&file, store.snapshotPath)) {
+        const StatsSnapshot *snapshot = file.data;
+        if (file.size >= sizeof(*snapshot) && memcmp(snapshot->magic, "TTTS", 4) == 0 &&
+            snapshot->version == STATS_VERSION) {
+            memcpy(store.written, snapshot->counts, sizeof(store.written));
+            store.generation = snapshot->generation;
+        }
+        MappedFileClose(&file);
+    }
+
+    bool clean = false;
+    if (MappedFileOpen(&file, store.journalPath)) {
+        const StatsJournalHeader *header = file.data;
+        if (file.size >= sizeof(*header) && memcmp(header->magic, "TTTJ", 4) == 0 &&
+            header->version == STATS_VERSION && header->generation == store.generation) {
+            const StatsRecord *records = (const StatsRecord *)(header + 1);
+            size_t count = (file.size - sizeof(*header)) / sizeof(StatsRecord);
+            size_t valid = 0;
+            for (; valid < count && RecordValid(&records[valid]); valid++) {
+                store.written[records[valid].difficulty][records[valid].result]++;
+            }
+            store.journalRecords = (long long)valid;
+            clean = sizeof(*header) + valid * sizeof(StatsRecord) == file.size;
+        }
+        MappedFileClose(&file);
+    }
+    return clean;
+}
+
+// Moves everything written into a new snapshot and starts an empty journal
+static bool Compact(void)
+{
+    StatsSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    memcpy(snapshot.magic, "TTTS", 4);
+    snapshot.version = STATS_VERSION;
+    snapshot.generation = store.generation + 1;
+    memcpy(snapshot.counts, store.written, sizeof(snapshot.counts));
+
+    char tempPath[STATS_MAX_PATH + 8];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", store.snapshotPath);
+    FILE *file = fopen(tempPath, "wb");
+    bool ok = file != NULL && fwrite(&snapshot, sizeof(snapshot), 1, file) == 1 && FileSync(file);
+    if (file != NULL) ok = fclose(file) == 0 && ok;
+    if (!ok || !FileReplace(tempPath, store.snapshotPath)) return false;
+
+    // The old journal is now counted in the snapshot, and is ignored for its generation until it is replaced
+    store.generation++;
+    if (store.journal != NULL) fclose(store.journal);
+    store.journal = fopen(store.journalPath, "wb");
+    store.journalRecords = 0;
+
+    StatsJournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TTTJ", 4);
+    header.version = STATS_VERSION;
+    header.generation = store.generation;
+    return store.journal != NULL && fwrite(&header, sizeof(header), 1, store.journal) == 1 && FileSync(store.journal);
+}
+
+static void WriteBatch(const StatsRecord *records, size_t count)
+{
+    bool ok = store.journal != NULL && fwrite(records, sizeof(StatsRecord), count, store.journal) == count &&
+              FileSync(store.journal);
+    if (ok) {
+        for (size_t i = 0; i < count; i++) store.written[records[i].difficulty][records[i].result]++;
+        store.journalRecords += (long long)count;
+        if (store.journalRecords >= STATS_COMPACT_RECORDS) ok = Compact();
+    }
+    if (!ok && !store.failed) {
+        printf("Error writing game stats to %s!\n", store.journalPath);
+        store.failed = true;
+    }
+}
+
+static void *WriterMain(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&store.lock);
+    for (;;) {
+        while (store.pendingCount == 0 && !store.stopping) pthread_cond_wait(&store.wake, &store.lock);
+        if (store.pendingCount == 0) break;
+
+        // Let the batch fill up for a while, unless the store is closing
+        if (!store.stopping) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += STATS_BATCH_MS * 1000000L;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            while (!store.stopping && pthread_cond_timedwait(&store.wake, &store.lock, &until) != ETIMEDOUT) {}
+        }
+
+        // Swap buffers so recording goes on while this batch is written
+        StatsRecord *batch = store.pending;
+        size_t count = store.pendingCount;
+        size_t capacity = store.pendingCapacity;
+        store.pending = store.writing;
+        store.pendingCapacity = store.writingCapacity;
+        store.pendingCount = 0;
+        store.writing = batch;
+        store.writingCapacity = capacity;
+
+        pthread_mutex_unlock(&store.lock);
+        WriteBatch(batch, count);
+        pthread_mutex_lock(&store.lock);
+    }
+    pthread_mutex_unlock(&store.lock);
+    return NULL;
+}
+
+bool StatsStoreOpen(const char *path)
+{
+    StatsStoreClose();
+    memset(&store, 0, sizeof(store));
+    snprintf(store.snapshotPath, sizeof(store.snapshotPath), "%s", path);
+    snprintf(store.journalPath, sizeof(store.journalPath), "%s.journal", path);
+
+    bool clean = LoadFiles();
+    bool ok = (clean && store.journalRecords < STATS_COMPACT_RECORDS)
+        ? (store.journal = fopen(store.journalPath, "ab")) != NULL
+        : Compact();
+    memcpy(store.totals, store.written, sizeof(store.totals));
+
+    if (ok) {
+        pthread_mutex_init(&store.lock, NULL);
+        pthread_cond_init(&store.wake, NULL);
+        ok = pthread_create(&store.writer, NULL, WriterMain, NULL) == 0;
+        if (!ok) {
+            pthread_mutex_destroy(&store.lock);
+            pthread_cond_destroy(&store.wake);
+        }
+    }
+    if (!ok) {
+        printf("Error opening game stats %s!\n", path);
+        if (store.journal != NULL) fclose(store.journal);
+        store.journal = NULL;
+        return false;
+    }
+    store.open = true;
+    return true;
+}
+
+void StatsStoreRecord(Difficulty difficulty, StatsResult result)
+{
+    if (!store.open) return;
+    pthread_mutex_lock(&store.lock);
+    store.totals[difficulty][result]++;
+
+    if (store.pendingCount == store.pendingCapacity) {
+        size_t capacity = store.pendingCapacity ? store.pendingCapacity * 2 : 1024;
+        StatsRecord *grown = realloc(store.pending, capacity * sizeof(StatsRecord));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&store.lock);
+            return;     // counted for this run, but not kept
+        }
+        store.pending = grown;
+        store.pendingCapacity = capacity;
+    }
+    store.pending[store.pendingCount++] = (StatsRecord){ STATS_RECORD_TAG, (uint8_t)difficulty, (uint8_t)result, 0 };
+
+    // The writer sleeps until a batch starts
+    if (store.pendingCount == 1) pthread_cond_signal(&store.wake);
+    pthread_mutex_unlock(&store.lock);
+}
+
+void StatsStoreTotals(DifficultyStats totals[HARD + 1])
+{
+    if (store.open) pthread_mutex_lock(&store.lock);
+    for (int difficulty = EASY; difficulty <= HARD; difficulty++) {
+        const int64_t *counts = store.totals[difficulty];
+        totals[difficulty].wins = (int)counts[STATS_WIN];
+        totals[difficulty].losses = (int)counts[STATS_LOSS];
+        totals[difficulty].draws = (int)counts[STATS_DRAW];
+        totals[difficulty].totalGames = (int)(counts[STATS_WIN] + counts[STATS_LOSS] + counts[STATS_DRAW]);
+    }
+    if (store.open) pthread_mutex_unlock(&store.lock);
+}
+
+void StatsStoreClose(void)
+{
+    if (!store.open) return;
+    pthread_mutex_lock(&store.lock);
+    store.stopping = true;
+    pthread_cond_signal(&store.wake);
+    pthread_mutex_unlock(&store.lock);
+    pthread_join(store.writer, NULL);
+
+    if (store.journal != NULL) fclose(store.journal);
+    store.journal = NULL;
+    pthread_mutex_destroy(&store.lock);
+    pthread_cond_destroy(&store.wake);
+    free(store.pending);
+    free(store.writing);
+    store.pending = store.writing = NULL;
+    store.open = false;
+}
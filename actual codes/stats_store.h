@@ -0,0 +1,61 @@
+#ifndef STATS_STORE_H
+#define STATS_STORE_H
+
+#include "engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Results of every game against the AI, kept across launches. Each result
+// is a 4-byte record appended to a journal next to a snapshot of the totals.
+// Opening the store maps both files and adds them up. Recording a result
+// only updates the totals and queues the record: a writer thread appends
+// what has queued up as one batch with one fsync, so a burst of games costs
+// a single sync and never blocks the caller. Once the journal holds
+// STATS_COMPACT_RECORDS records the writer folds it into a new snapshot,
+// written aside and renamed into place, and starts an empty journal. Both
+// files carry a generation number, so a crash between the two steps doesn't
+// count the old journal twice, and a torn record at the end of the journal
+// is dropped on load. One process should use the store at a time.
+
+#define STATS_DEFAULT_FILE "tictactoe.stats"   // the journal is <file>.journal
+#define STATS_VERSION 1
+#define STATS_BATCH_MS 100                      // longest a result waits to be written
+#define STATS_COMPACT_RECORDS (1 << 20)
+#define STATS_MAX_PATH 256
+
+typedef enum { STATS_WIN, STATS_LOSS, STATS_DRAW } StatsResult;  // for the AI
+
+typedef struct {
+    uint8_t tag;            // STATS_RECORD_TAG, tells a record from a zeroed tail
+    uint8_t difficulty;
+    uint8_t result;
+    uint8_t reserved;
+} StatsRecord;
+
+#define STATS_RECORD_TAG 0xA5
+
+typedef struct {
+    char magic[4];          // "TTTS"
+    uint32_t version;
+    uint64_t generation;    // journals of older generations are already counted
+    int64_t counts[HARD + 1][STATS_DRAW + 1];
+} StatsSnapshot;
+
+typedef struct {
+    char magic[4];          // "TTTJ"
+    uint32_t version;
+    uint64_t generation;
+} StatsJournalHeader;
+
+// Loads the totals and starts the writer; false if the files can't be written
+bool StatsStoreOpen(const char *path);
+
+void StatsStoreRecord(Difficulty difficulty, StatsResult result);
+
+// Totals over every recorded game, indexed by Difficulty
+void StatsStoreTotals(DifficultyStats totals[HARD + 1]);
+
+// Writes whatever is still queued and stops the writer
+void StatsStoreClose(void);
+
+#endif // STATS_STORE_H
@@ -0,0 +1,302 @@
+#include "tablebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TB_VERSION 1
+
+static uint64_t binomial[TB_MAX_CELLS + 1][TB_MAX_CELLS + 1];
+
+static void InitBinomials(void)
+{
+    if (binomial[0][0] == 1) return;
+    for (int n = 0; n <= TB_MAX_CELLS; n++) {
+        binomial[n][0] = 1;
+        for (int k = 1; k <= n; k++) {
+            binomial[n][k] = binomial[n - 1][k - 1] + (k < n ? binomial[n - 1][k] : 0);
+        }
+    }
+}
+
+// X always moves first, so the piece counts follow from the number of empty cells
+static int XCount(int cellCount, int empty) { return (cellCount - empty + 1) / 2; }
+
+static uint64_t SliceCount(int cellCount, int empty)
+{
+    int filled = cellCount - empty;
+    return binomial[cellCount][empty] * binomial[filled][XCount(cellCount, empty)];
+}
+
+// Colex rank of a k-subset of {0..n-1}
+static uint64_t RankSubset(uint32_t mask)
+{
+    uint64_t rank = 0;
+    int k = 1;
+    while (mask) {
+        int bit = __builtin_ctz(mask);
+        if (bit >= k) rank += binomial[bit][k];
+        k++;
+        mask &= mask - 1;
+    }
+    return rank;
+}
+
+static uint32_t UnrankSubset(uint64_t rank, int n, int k)
+{
+    uint32_t mask = 0;
+    for (int bit = n - 1; k > 0; bit--) {
+        uint64_t c = (bit >= k) ? binomial[bit][k] : 0;
+        if (rank >= c) {
+            rank -= c;
+            mask |= (uint32_t)1 << bit;
+            k--;
+        }
+    }
+    return mask;
+}
+
+// Squeezes the bits of value selected by mask together (a portable pext)
+static uint32_t Compress(uint32_t value, uint32_t mask)
+{
+    uint32_t result = 0;
+    int out = 0;
+    while (mask) {
+        uint32_t bit = mask & -mask;
+        if (value & bit) result |= (uint32_t)1 << out;
+        out++;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+static uint32_t Expand(uint32_t value, uint32_t mask)
+{
+    uint32_t result = 0;
+    while (mask) {
+        uint32_t bit = mask & -mask;
+        if (value & 1) result |= bit;
+        value >>= 1;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+static uint64_t PositionIndex(int cellCount, uint32_t xMask, uint32_t oMask)
+{
+    uint32_t all = ((uint64_t)1 << cellCount) - 1;
+    uint32_t emptyMask = all & ~(xMask | oMask);
+    int empty = __builtin_popcount(emptyMask);
+    int filled = cellCount - empty;
+    uint64_t xRank = RankSubset(Compress(xMask, xMask | oMask));
+    return RankSubset(emptyMask) * binomial[filled][XCount(cellCount, empty)] + xRank;
+}
+
+static void PositionFromIndex(int cellCount, int empty, uint64_t index, uint32_t *xMask, uint32_t *oMask)
+{
+    int filled = cellCount - empty;
+    int xCount = XCount(cellCount, empty);
+    uint64_t xRanks = binomial[filled][xCount];
+    uint32_t all = ((uint64_t)1 << cellCount) - 1;
+    uint32_t filledMask = all & ~UnrankSubset(index / xRanks, cellCount, empty);
+
+    *xMask = Expand(UnrankSubset(index % xRanks, filled, xCount), filledMask);
+    *oMask = filledMask & ~*xMask;
+}
+
+static bool BoardMasks(const Board *board, uint32_t *xMask, uint32_t *oMask)
+{
+    if (board->geo->cellCount > TB_MAX_CELLS) return false;
+    *xMask = (uint32_t)board->pieces[0].w[0];
+    *oMask = (uint32_t)board->pieces[1].w[0];
+    return true;
+}
+
+static bool MaskHasLine(const BoardGeometry *geo, const uint32_t *lineMasks, uint32_t pieces)
+{
+    for (int line = 0; line < geo->lineCount; line++) {
+        if ((pieces & lineMasks[line]) == lineMasks[line]) return true;
+    }
+    return false;
+}
+
+// Resolves one position from the already built slice below it
+static unsigned char SolvePosition(const BoardGeometry *geo, const uint32_t *lineMasks, int empty,
+                                   uint32_t xMask, uint32_t oMask, const unsigned char *childSlice)
+{
+    bool xToMove = (geo->cellCount - empty) % 2 == 0;
+    uint32_t mover = xToMove ? xMask : oMask;
+    uint32_t lastMover = xToMove ? oMask : xMask;
+
+    if (MaskHasLine(geo, lineMasks, mover)) return TB_INVALID; // the game would have ended earlier
+    if (MaskHasLine(geo, lineMasks, lastMover)) return TB_VALUE(TB_LOSS, 0);
+    if (empty == 0) return TB_VALUE(TB_DRAW, 0);
+
+    uint32_t all = ((uint64_t)1 << geo->cellCount) - 1;
+    uint32_t emptyMask = all & ~(xMask | oMask);
+    int bestWin = 64, worstLoss = -1;
+    bool canDraw = false;
+
+    while (emptyMask) {
+        uint32_t bit = emptyMask & -emptyMask;
+        emptyMask &= emptyMask - 1;
+
+        uint32_t childX = xToMove ? (xMask | bit) : xMask;
+        uint32_t childO = xToMove ? oMask : (oMask | bit);
+        unsigned char child = childSlice[PositionIndex(geo->cellCount, childX, childO)];
+        int distance = TB_DISTANCE(child) + 1;
+
+        // The child is scored for the opponent
+        if (TB_RESULT(child) == TB_LOSS && distance < bestWin) bestWin = distance;
+        else if (TB_RESULT(child) == TB_DRAW) canDraw = true;
+        else if (TB_RESULT(child) == TB_WIN && distance > worstLoss) worstLoss = distance;
+    }
+
+    if (bestWin < 64) return TB_VALUE(TB_WIN, bestWin);
+    if (canDraw) return TB_VALUE(TB_DRAW, 0);
+    return TB_VALUE(TB_LOSS, worstLoss);
+}
+
+bool TablebaseBuild(const char *path, const BoardGeometry *geo, int maxEmpty, size_t chunkEntries)
+{
+    if (geo->cellCount > TB_MAX_CELLS || maxEmpty > geo->cellCount || chunkEntries == 0) return false;
+    InitBinomials();
+
+    uint32_t lineMasks[BOARD_MAX_LINES];
+    for (int line = 0; line < geo->lineCount; line++) {
+        lineMasks[line] = (uint32_t)geo->lineMask[line].w[0];
+    }
+
+    FILE *file = fopen(path, "w+b");
+    if (file == NULL) {
+        fprintf(stderr, "Error creating tablebase file!\n");
+        return false;
+    }
+
+    TablebaseHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "TTTB", 4);
+    header.version = TB_VERSION;
+    header.size = (uint32_t)geo->size;
+    header.winLength = (uint32_t)geo->winLength;
+    header.maxEmpty = (uint32_t)maxEmpty;
+
+    unsigned char *chunk = malloc(chunkEntries);
+    bool ok = chunk != NULL && fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t offset = sizeof(header);
+
+    for (int empty = 0; ok && empty <= maxEmpty; empty++) {
+        header.sliceOffset[empty] = offset;
+        header.sliceCount[empty] = SliceCount(geo->cellCount, empty);
+
+        // The previous slice is read back through a mapping so it never has to fit in memory
+        MappedFile previous = {0};
+        const unsigned char *childSlice = NULL;
+        if (empty > 0) {
+            fflush(file);
+            if (!MappedFileOpen(&previous, path)) {
+                ok = false;
+                break;
+            }
+            childSlice = (const unsigned char *)previous.data + header.sliceOffset[empty - 1];
+        }
+
+        for (uint64_t start = 0; ok && start < header.sliceCount[empty]; start += chunkEntries) {
+            uint64_t end = start + chunkEntries;
+            if (end > header.sliceCount[empty]) end = header.sliceCount[empty];
+
+            for (uint64_t index = start; index < end; index++) {
+                uint32_t xMask, oMask;
+                PositionFromIndex(geo->cellCount, empty, index, &xMask, &oMask);
+                chunk[index - start] = SolvePosition(geo, lineMasks, empty, xMask, oMask, childSlice);
+            }
+            ok = fwrite(chunk, 1, (size_t)(end - start), file) == (size_t)(end - start);
+        }
+
+        if (empty > 0) MappedFileClose(&previous);
+        offset += header.sliceCount[empty];
+    }
+
+    // Rewrite the header now that every slice offset is known
+    if (ok) {
+        ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    free(chunk);
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Error writing tablebase file!\n");
+        remove(path);
+    }
+    return ok;
+}
+
+bool TablebaseOpen(Tablebase *tb, const char *path, const BoardGeometry *geo)
+{
+    memset(tb, 0, sizeof(*tb));
+    InitBinomials();
+    if (geo->cellCount > TB_MAX_CELLS || !MappedFileOpen(&tb->file, path)) return false;
+
+    const TablebaseHeader *header = tb->file.data;
+    bool valid = tb->file.size >= sizeof(TablebaseHeader) &&
+                 memcmp(header->magic, "TTTB", 4) == 0 &&
+                 header->version == TB_VERSION &&
+                 header->size == (uint32_t)geo->size &&
+                 header->winLength == (uint32_t)geo->winLength &&
+                 header->maxEmpty <= (uint32_t)geo->cellCount && header->maxEmpty <= TB_MAX_CELLS &&
+                 header->sliceCount[header->maxEmpty] <= tb->file.size &&
+                 header->sliceOffset[header->maxEmpty] <= tb->file.size - header->sliceCount[header->maxEmpty];
+    if (!valid) {
+        MappedFileClose(&tb->file);
+        return false;
+    }
+
+    tb->header = header;
+    tb->data = tb->file.data;
+    tb->cellCount = geo->cellCount;
+    tb->maxEmpty = (int)header->maxEmpty;
+    return true;
+}
+
+void TablebaseClose(Tablebase *tb)
+{
+    MappedFileClose(&tb->file);
+    memset(tb, 0, sizeof(*tb));
+}
+
+unsigned char TablebaseProbe(const Tablebase *tb, const Board *board)
+{
+    uint32_t xMask, oMask;
+    if (tb->data == NULL || board->geo->cellCount != tb->cellCount) return TB_INVALID;
+    if (BoardEmptyCount(board) > tb->maxEmpty || !BoardMasks(board, &xMask, &oMask)) return TB_INVALID;
+
+    int empty = BoardEmptyCount(board);
+    if (__builtin_popcount(xMask) != XCount(tb->cellCount, empty)) return TB_INVALID;
+    return tb->data[tb->header->sliceOffset[empty] + PositionIndex(tb->cellCount, xMask, oMask)];
+}
+
+int TablebaseBestMove(const Tablebase *tb, const Board *board, unsigned char *outValue)
+{
+    unsigned char value = TablebaseProbe(tb, board);
+    if (value == TB_INVALID || BoardEmptyCount(board) == 0) return -1;
+    if (TB_RESULT(value) == TB_LOSS && TB_DISTANCE(value) == 0) return -1; // already lost
+
+    // Every covered position's children are covered too, so pick the child that realises the value
+    Board child = *board;
+    Cell mover = BoardSideToMove(board);
+    int bestMove = -1;
+    for (int cell = 0; cell < board->geo->cellCount && bestMove == -1; cell++) {
+        if (BoardGetCell(board, cell) != EMPTY) continue;
+
+        BoardMakeMove(&child, cell, mover);
+        unsigned char childValue = TablebaseProbe(tb, &child);
+        BoardUnmakeMove(&child);
+
+        int expected = TB_RESULT(value) == TB_WIN ? TB_LOSS : TB_RESULT(value) == TB_LOSS ? TB_WIN : TB_DRAW;
+        if (TB_RESULT(childValue) == expected &&
+            (expected == TB_DRAW || TB_DISTANCE(childValue) + 1 == TB_DISTANCE(value))) {
+            bestMove = cell;
+        }
+    }
+
+    if (outValue != NULL) *outValue = value;
+    return bestMove;
+}
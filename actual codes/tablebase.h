@@ -0,0 +1,59 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "board.h"
+#include "mapped_file.h"
+#include <stddef.h>
+
+// Endgame tablebase built by retrograde analysis.
+// Positions are grouped into slices by their number of empty cells. Slice 0
+// (full boards) holds only terminal positions, and every later slice is
+// resolved from the slice before it, so values flow backwards from the
+// terminal positions towards the opening.
+
+#define TB_MAX_CELLS 25       // positions are indexed with 32-bit cell masks
+#define TB_DEFAULT_FILE "tictactoe.tb"
+
+// One byte per position, from the side to move's point of view:
+// the top two bits hold the result, the low six the plies until the game ends
+#define TB_INVALID 0
+#define TB_LOSS 1
+#define TB_DRAW 2
+#define TB_WIN 3
+#define TB_VALUE(result, distance) ((unsigned char)(((result) << 6) | ((distance) & 63)))
+#define TB_RESULT(value) ((value) >> 6)
+#define TB_DISTANCE(value) ((value) & 63)
+
+typedef struct {
+    char magic[4];      // "TTTB"
+    uint32_t version;
+    uint32_t size;
+    uint32_t winLength;
+    uint32_t maxEmpty;
+    uint32_t reserved;
+    uint64_t sliceOffset[TB_MAX_CELLS + 1];
+    uint64_t sliceCount[TB_MAX_CELLS + 1];
+} TablebaseHeader;
+
+typedef struct {
+    MappedFile file;
+    const TablebaseHeader *header;
+    const unsigned char *data;
+    int cellCount;
+    int maxEmpty;
+} Tablebase;
+
+// Builds slices 0..maxEmpty and writes them to path. Only chunkEntries values
+// are held in memory at once; earlier slices are read back through a mapping.
+bool TablebaseBuild(const char *path, const BoardGeometry *geo, int maxEmpty, size_t chunkEntries);
+
+bool TablebaseOpen(Tablebase *tb, const char *path, const BoardGeometry *geo);
+void TablebaseClose(Tablebase *tb);
+
+// Returns TB_INVALID when the position is not covered by the table
+unsigned char TablebaseProbe(const Tablebase *tb, const Board *board);
+
+// Best move for the side to move, or -1 if the position is not covered
+int TablebaseBestMove(const Tablebase *tb, const Board *board, unsigned char *outValue);
+
+#endif // TABLEBASE_H
@@ -0,0 +1,128 @@
+#include "text_layout.h"
+#include "profiler.h"
+#include <string.h>
+
+#define CACHE_SIZE (1 << TEXT_LAYOUT_CACHE_BITS)
+#define DEFAULT_FONT_SIZE 10    // raylib's own, for the DrawText spacing rule
+
+static TextLayout cache[CACHE_SIZE];
+
+static uint64_t Hash(Font font, const char *text, float size, float spacing)
+{
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    for (const char *c = text; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 1099511628211ULL;
+    }
+    hash ^= (uint64_t)font.texture.id << 32 ^ (uint64_t)font.baseSize << 16;
+    hash ^= (uint64_t)(size * 64.0f) << 40 ^ (uint64_t)(spacing * 64.0f) << 8;
+    hash *= 0x9e3779b97f4a7c15ULL;
+    return hash != 0 ? hash : 1;
+}
+
+// Same arithmetic as MeasureTextEx and DrawTextEx, done once
+static bool Build(TextLayout *layout, Font font, const char *text, float size, float spacing)
+{
+    float scale = size / (float)font.baseSize;
+    float advance = 0.0f;   // unscaled, as MeasureTextEx sums it
+    float x = 0.0f;         // where DrawTextEx puts the next glyph
+    int codepoints = 0;
+
+    layout->glyphCount = 0;
+    for (int i = 0; text[i] != '\0';) {
+        int bytes = 0;
+        int codepoint = GetCodepointNext(&text[i], &bytes);
+        if (codepoint == '\n' || layout->glyphCount == TEXT_LAYOUT_MAX_GLYPHS) return false;
+        int index = GetGlyphIndex(font, codepoint);
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            layout->glyphs[layout->glyphCount].index = (short)index;
+            layout->glyphs[layout->glyphCount].x = x;
+            layout->glyphCount++;
+        }
+
+        if (font.glyphs[index].advanceX != 0) {
+            advance += font.glyphs[index].advanceX;
+            x += font.glyphs[index].advanceX * scale + spacing;
+        } else {
+            advance += font.recs[index].width + font.glyphs[index].offsetX;
+            x += font.recs[index].width * scale + spacing;
+        }
+        codepoints++;
+        i += bytes;
+    }
+
+    layout->extent.x = codepoints > 0 ? advance * scale + (float)((codepoints - 1) * spacing) : 0.0f;
+    layout->extent.y = size;
+    return true;
+}
+
+const TextLayout *TextLayoutGet(Font font, const char *text, float size, float spacing)
+{
+    if (font.glyphs == NULL || font.baseSize == 0 || strlen(text) >= TEXT_LAYOUT_MAX_BYTES) return NULL;
+
+    uint64_t key = Hash(font, text, size, spacing);
+    TextLayout *layout = &cache[key & (CACHE_SIZE - 1)];
+    if (layout->key == key && layout->font.texture.id == font.texture.id && layout->size == size &&
+        layout->spacing == spacing && strcmp(layout->text, text) == 0) {
+        return layout;
+    }
+
+    layout->key = 0;
+    if (!Build(layout, font, text, size, spacing)) return NULL;
+    layout->key = key;
+    layout->font = font;
+    layout->size = size;
+    layout->spacing = spacing;
+    strcpy(layout->text, text);
+    return layout;
+}
+
+void TextLayoutDraw(const TextLayout *layout, Vector2 position, Color tint)
+{
+    // Same rectangles DrawTextCodepoint would work out for each glyph
+    const Font *font = &layout->font;
+    float scale = layout->size / (float)font->baseSize;
+    float padding = (float)font->glyphPadding;
+    for (int i = 0; i < layout->glyphCount; i++) {
+        int index = layout->glyphs[i].index;
+        Rectangle rec = font->recs[index];
+        Rectangle source = { rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding };
+        Rectangle dest = {
+            position.x + layout->glyphs[i].x + (font->glyphs[index].offsetX - padding) * scale,
+            position.y + (font->glyphs[index].offsetY - padding) * scale,
+            source.width * scale,
+            source.height * scale
+        };
+        DrawTexturePro(font->texture, source, dest, (Vector2){ 0, 0 }, 0.0f, tint);
+    }
+    ProfilerCountDraws(layout->glyphCount);
+}
+
+int LayoutMeasureText(const char *text, int fontSize)
+{
+    if (fontSize < DEFAULT_FONT_SIZE) fontSize = DEFAULT_FONT_SIZE;
+    return (int)LayoutMeasureTextEx(GetFontDefault(), text, (float)fontSize, (float)(fontSize / DEFAULT_FONT_SIZE)).x;
+}
+
+void LayoutDrawText(const char *text, int posX, int posY, int fontSize, Color color)
+{
+    if (fontSize < DEFAULT_FONT_SIZE) fontSize = DEFAULT_FONT_SIZE;
+    Vector2 position = { (float)posX, (float)posY };
+    LayoutDrawTextEx(GetFontDefault(), text, position, (float)fontSize, (float)(fontSize / DEFAULT_FONT_SIZE), color);
+}
+
+Vector2 LayoutMeasureTextEx(Font font, const char *text, float fontSize, float spacing)
+{
+    const TextLayout *layout = TextLayoutGet(font, text, fontSize, spacing);
+    return layout != NULL ? layout->extent : MeasureTextEx(font, text, fontSize, spacing);
+}
+
+void LayoutDrawTextEx(Font font, const char *text, Vector2 position, float fontSize, float spacing, Color tint)
+{
+    const TextLayout *layout = TextLayoutGet(font, text, fontSize, spacing);
+    if (layout != NULL) TextLayoutDraw(layout, position, tint);
+    else {
+        DrawTextEx(font, text, position, fontSize, spacing, tint);
+        ProfilerCountDraws((int)strlen(text));
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Text layout cache: measuring or drawing a string decodes its UTF-8 and
+// looks up every glyph, which the screens used to do for every label on
+// every frame. A layout keeps the result per (string, font, size): the
+// measured extent and the run of glyphs with their x offsets, so drawing
+// it again is just the glyph blits. Layouts live in a direct-mapped table
+// and a colliding string replaces the old entry. Strings that are too long,
+// or span lines, bypass the cache.
+
+#define TEXT_LAYOUT_CACHE_BITS 8
+#define TEXT_LAYOUT_MAX_BYTES 128
+#define TEXT_LAYOUT_MAX_GLYPHS 96
+
+typedef struct {
+    short index;    // into the font's glyphs and recs
+    float x;        // from the start of the string, already scaled
+} TextGlyph;
+
+typedef struct {
+    uint64_t key;   // hash of the string, font and size; 0 = empty slot
+    Font font;
+    float size;
+    float spacing;
+    char text[TEXT_LAYOUT_MAX_BYTES];
+    Vector2 extent;
+    int glyphCount;
+    TextGlyph glyphs[TEXT_LAYOUT_MAX_GLYPHS];
+} TextLayout;
+
+// NULL if the string can't be cached
+const TextLayout *TextLayoutGet(Font font, const char *text, float size, float spacing);
+void TextLayoutDraw(const TextLayout *layout, Vector2 position, Color tint);
+
+// Cached stand-ins for raylib's MeasureText, DrawText, MeasureTextEx and DrawTextEx
+int LayoutMeasureText(const char *text, int fontSize);
+void LayoutDrawText(const char *text, int posX, int posY, int fontSize, Color color);
+Vector2 LayoutMeasureTextEx(Font font, const char *text, float fontSize, float spacing);
+void LayoutDrawTextEx(Font font, const char *text, Vector2 position, float fontSize, float spacing, Color tint);
+
+#endif // TEXT_LAYOUT_H
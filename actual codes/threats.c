@@ -0,0 +1,293 @@
+#include "threats.h"
+#include "platform.h"
+#include <stdlib.h>
+
+#define THREAT_LEVELS 3
+
+bool ThreatSearchInit(ThreatSearch *search, int tableBits)
+{
+    memset(search, 0, sizeof(*search));
+    search->table = calloc((size_t)1 << tableBits, sizeof(ThreatEntry));
+    if (search->table == NULL) return false;
+    search->mask = ((size_t)1 << tableBits) - 1;
+    return true;
+}
+
+void ThreatSearchFree(ThreatSearch *search)
+{
+    free(search->table);
+    memset(search, 0, sizeof(*search));
+}
+
+// Adds (sign = 1) or removes (sign = -1) a line's share of the threat counters
+static void CountLine(ThreatSearch *search, int line, int sign)
+{
+    const Board *board = &search->board;
+    const BoardGeometry *geo = board->geo;
+
+    for (int side = 0; side < 2; side++) {
+        if (board->lineCount[1 - side][line] != 0) continue;
+        int missing = geo->winLength - board->lineCount[side][line];
+        if (missing < 1 || missing > THREAT_LEVELS) continue;
+
+        unsigned char *counts = search->lineThreats[missing - 1][side];
+        for (int i = 0; i < geo->winLength; i++) {
+            int cell = geo->lineCells[line][i];
+            if (BoardGetCell(board, cell) != EMPTY) continue;
+
+            if (missing == 1 && sign > 0 && counts[cell] == 0) search->winningCells[side]++;
+            counts[cell] = (unsigned char)(counts[cell] + sign);
+            if (missing == 1 && sign < 0 && counts[cell] == 0) search->winningCells[side]--;
+        }
+    }
+}
+
+// Only the lines through the cell change, so only their counts are redone
+static void MakeMove(ThreatSearch *search, int cell, Cell player)
+{
+    const BoardGeometry *geo = search->board.geo;
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) CountLine(search, geo->cellLines[cell][i], -1);
+    BoardMakeMove(&search->board, cell, player);
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) CountLine(search, geo->cellLines[cell][i], 1);
+}
+
+static void UnmakeMove(ThreatSearch *search)
+{
+    const BoardGeometry *geo = search->board.geo;
+    int cell = search->board.moves[search->board.ply - 1] & ~BOARD_MOVE_O;
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) CountLine(search, geo->cellLines[cell][i], -1);
+    BoardUnmakeMove(&search->board);
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) CountLine(search, geo->cellLines[cell][i], 1);
+}
+
+static int WinningCells(const ThreatSearch *search, int side, unsigned short *cells, int max)
+{
+    const unsigned char *fours = search->lineThreats[0][side];
+    int count = 0;
+    for (int cell = 0; cell < search->board.geo->cellCount && count < max; cell++) {
+        if (fours[cell] > 0) cells[count++] = (unsigned short)cell;
+    }
+    return count;
+}
+
+// True if playing the cell would give the side two different winning cells
+static bool MakesDoubleFour(const ThreatSearch *search, int side, int cell)
+{
+    const Board *board = &search->board;
+    const BoardGeometry *geo = board->geo;
+    if (search->lineThreats[1][side][cell] < 2) return false;
+
+    // Overlapping lines in one direction can share their other empty cell
+    int first = -1;
+    for (int i = 0; i < geo->cellLineCount[cell]; i++) {
+        int line = geo->cellLines[cell][i];
+        if (board->lineCount[1 - side][line] != 0 || geo->winLength - board->lineCount[side][line] != 2) continue;
+
+        for (int j = 0; j < geo->winLength; j++) {
+            int other = geo->lineCells[line][j];
+            if (other == cell || BoardGetCell(board, other) != EMPTY) continue;
+            if (first == -1) first = other;
+            else if (other != first) return true;
+        }
+    }
+    return false;
+}
+
+// Moves that make a four or build towards a double four, most forcing first
+static int AttackingMoves(const ThreatSearch *search, int side, unsigned short *cells)
+{
+    int scores[BOARD_MAX_CELLS];
+    int count = 0;
+
+    for (int cell = 0; cell < search->board.geo->cellCount; cell++) {
+        int threes = search->lineThreats[1][side][cell];
+        int twos = search->lineThreats[2][side][cell];
+        if (threes == 0 && twos == 0) continue;
+        if (BoardGetCell(&search->board, cell) != EMPTY) continue;
+
+        // Insertion sort, the list is short
+        int score = threes * 64 + twos;
+        int i = count++;
+        while (i > 0 && scores[i - 1] < score) {
+            scores[i] = scores[i - 1];
+            cells[i] = cells[i - 1];
+            i--;
+        }
+        scores[i] = score;
+        cells[i] = (unsigned short)cell;
+    }
+    return count < THREAT_MAX_CANDIDATES ? count : THREAT_MAX_CANDIDATES;
+}
+
+// Replies to a double-four threat: the threatening cells, the other empty
+// cells of the lines behind them and any move that makes the defender a four.
+// Anything else leaves a double four on the board and loses two moves later.
+static int DefensiveMoves(const ThreatSearch *search, int attacker, unsigned short *cells)
+{
+    const Board *board = &search->board;
+    const BoardGeometry *geo = board->geo;
+    int defender = 1 - attacker;
+    bool chosen[BOARD_MAX_CELLS] = { false };
+    bool threatened = false;
+
+    for (int cell = 0; cell < geo->cellCount; cell++) {
+        if (BoardGetCell(board, cell) != EMPTY || !MakesDoubleFour(search, attacker, cell)) continue;
+        threatened = true;
+        chosen[cell] = true;
+
+        for (int i = 0; i < geo->cellLineCount[cell]; i++) {
+            int line = geo->cellLines[cell][i];
+            if (board->lineCount[defender][line] != 0 || geo->winLength - board->lineCount[attacker][line] != 2) continue;
+            for (int j = 0; j < geo->winLength; j++) chosen[geo->lineCells[line][j]] = true;
+        }
+    }
+    if (!threatened) return 0;
+
+    int count = 0;
+    for (int cell = 0; cell < geo->cellCount; cell++) {
+        if (BoardGetCell(board, cell) != EMPTY) continue;
+        if (chosen[cell] || search->lineThreats[1][defender][cell] > 0) cells[count++] = (unsigned short)cell;
+    }
+    return count;
+}
+
+// Nodes cost microseconds here, so the clock is cheap enough to read at every one
+static bool OutOfBudget(ThreatSearch *search)
+{
+    if (!search->aborted && search->deadline != 0 && TimerNowNs() > search->deadline) {
+        search->aborted = true;
+    }
+    return search->aborted;
+}
+
+static void StoreEntry(ThreatSearch *search, uint64_t key, int depth, bool win, int move)
+{
+    ThreatEntry *entry = &search->table[key & search->mask];
+    entry->key = key;
+    entry->depth = (unsigned char)depth;
+    entry->win = win;
+    entry->move = (short)move;
+}
+
+static bool Defend(ThreatSearch *search, int depth);
+
+// Attacker to move: true if a forcing move wins within `depth` attacker moves
+static bool Attack(ThreatSearch *search, int depth, int *bestMove)
+{
+    Board *board = &search->board;
+    Cell attacker = BoardSideToMove(board);
+    int side = SideIndex(attacker);
+    unsigned short cells[BOARD_MAX_CELLS];
+    search->nodes++;
+
+    if (search->winningCells[side] > 0 && WinningCells(search, side, cells, 1) == 1) {
+        *bestMove = cells[0];
+        return true;
+    }
+    if (depth == 0 || OutOfBudget(search)) return false;
+
+    uint64_t key = BoardHash(board);
+    const ThreatEntry *entry = &search->table[key & search->mask];
+    if (entry->key == key) {
+        if (entry->win && entry->depth <= depth) {
+            *bestMove = entry->move;
+            return true;
+        }
+        if (!entry->win && entry->depth >= depth) return false;
+    }
+
+    int count;
+    if (search->winningCells[1 - side] > 0) {
+        // The defender threatens to win, so blocking is the only move (two threats can't both be blocked)
+        count = search->winningCells[1 - side] == 1 ? WinningCells(search, 1 - side, cells, 1) : 0;
+    } else {
+        count = AttackingMoves(search, side, cells);
+    }
+
+    for (int i = 0; i < count; i++) {
+        MakeMove(search, cells[i], attacker);
+        bool win = Defend(search, depth);
+        UnmakeMove(search);
+
+        if (win) {
+            *bestMove = cells[i];
+            StoreEntry(search, key, depth, true, cells[i]);
+            return true;
+        }
+        if (search->aborted) return false;
+    }
+
+    StoreEntry(search, key, depth, false, -1);
+    return false;
+}
+
+// Defender to move: true if every reply that matters still loses
+static bool Defend(ThreatSearch *search, int depth)
+{
+    Board *board = &search->board;
+    Cell defender = BoardSideToMove(board);
+    int side = SideIndex(defender);
+    unsigned short cells[BOARD_MAX_CELLS];
+    search->nodes++;
+
+    if (board->completedLines[1 - side] > 0) return true;
+    if (search->winningCells[side] > 0) return false;      // the defender wins first
+    if (search->winningCells[1 - side] > 1) return true;   // only one four can be blocked
+
+    int count;
+    if (search->winningCells[1 - side] == 1) {
+        count = WinningCells(search, 1 - side, cells, 1);
+    } else {
+        count = DefensiveMoves(search, 1 - side, cells);
+        if (count == 0) return false; // the attacking move threatened nothing
+    }
+
+    for (int i = 0; i < count; i++) {
+        int move;
+        MakeMove(search, cells[i], defender);
+        bool win = Attack(search, depth - 1, &move);
+        UnmakeMove(search);
+        if (!win) return false;
+    }
+    return true;
+}
+
+bool ThreatSearchRun(ThreatSearch *search, const Board *board, int maxDepth, int budgetUs, ThreatResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->move = -1;
+    result->complete = true;
+
+    // Keys are only unique within one geometry
+    if (search->board.geo != board->geo) memset(search->table, 0, (search->mask + 1) * sizeof(ThreatEntry));
+
+    search->board = *board;
+    memset(search->lineThreats, 0, sizeof(search->lineThreats));
+    search->winningCells[0] = search->winningCells[1] = 0;
+    for (int line = 0; line < board->geo->lineCount; line++) CountLine(search, line, 1);
+
+    search->nodes = 0;
+    search->aborted = false;
+    search->deadline = budgetUs > 0 ? TimerNowNs() + (uint64_t)budgetUs * 1000 : 0;
+
+    if (BoardHasLine(board, PLAYER_X) || BoardHasLine(board, PLAYER_O) || BoardIsDrawn(board)) return false;
+
+    // Shallow wins first, so running out of time still keeps the shortest one found
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int move = -1;
+        bool win = Attack(search, depth, &move);
+        if (search->aborted) {
+            result->complete = false;
+            break;
+        }
+        result->depth = depth;
+        if (win) {
+            result->win = true;
+            result->move = move;
+            break;
+        }
+    }
+
+    result->nodes = search->nodes;
+    return result->win;
+}
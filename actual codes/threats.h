@@ -0,0 +1,60 @@
+#ifndef THREATS_H
+#define THREATS_H
+
+#include "board.h"
+
+// Threat-space search: answers "does the side to move have a forced win?"
+// by only expanding forcing moves, which keeps it usable on boards far too
+// big for a full-width search.
+//
+// A "four" is a line one piece short with nothing of the opponent's on it,
+// so its empty cell wins on the next move. A "three" is two pieces short;
+// playing into it makes a four. The attacker only plays moves that leave a
+// four, or a cell where one more move would make two fours at once, and the
+// defender is given every reply that could stop those threats (plus its own
+// fours). Any win reported is therefore a real forced win; not finding one
+// within the depth or time budget proves nothing.
+
+#define THREAT_DEFAULT_DEPTH 8          // attacker moves
+#define THREAT_DEFAULT_BUDGET_US 4000   // well inside a 60 FPS frame
+#define THREAT_DEFAULT_TABLE_BITS 14
+#define THREAT_MAX_CANDIDATES 24        // attacking moves tried per node
+
+typedef struct {
+    uint64_t key;
+    short move;
+    unsigned char depth;
+    unsigned char win;
+} ThreatEntry;
+
+typedef struct {
+    Board board;
+    // Per-cell threat counters, kept up to date on every move from the
+    // board's per-line piece counts: how many lines with no opposing piece
+    // through this empty cell are one ([0], fours), two ([1], threes) or
+    // three ([2]) pieces short for each side
+    unsigned char lineThreats[3][2][BOARD_MAX_CELLS];
+    int winningCells[2];    // cells with lineThreats[0] > 0
+    ThreatEntry *table;
+    size_t mask;
+    long long nodes;
+    uint64_t deadline;
+    bool aborted;
+} ThreatSearch;
+
+typedef struct {
+    bool win;           // a forced win was proven
+    int move;           // first move of the win, -1 if none
+    int depth;          // attacker moves needed, or the deepest depth searched
+    long long nodes;
+    bool complete;      // every depth up to the limit was searched in time
+} ThreatResult;
+
+bool ThreatSearchInit(ThreatSearch *search, int tableBits);
+void ThreatSearchFree(ThreatSearch *search);
+
+// Iterative deepening up to maxDepth attacker moves, stopping after
+// budgetUs microseconds (0 = no limit)
+bool ThreatSearchRun(ThreatSearch *search, const Board *board, int maxDepth, int budgetUs, ThreatResult *result);
+
+#endif // THREATS_H
@@ -0,0 +1,182 @@
+#include "trace.h"
+#include "platform.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint64_t ns;
+    long long value;
+    char phase;
+} TraceEvent;
+
+typedef struct TraceChunk {
+    TraceEvent events[TRACE_CHUNK_EVENTS];
+    atomic_int count;                   // published with release, so a flush sees whole events
+    _Atomic(struct TraceChunk *) next;
+} TraceChunk;
+
+typedef struct TraceBuffer {
+    int tid;
+    char name[32];
+    TraceChunk *first;
+    TraceChunk *last;                   // only the owning thread appends
+    int chunks;
+    atomic_llong dropped;
+    struct TraceBuffer *next;
+} TraceBuffer;
+
+atomic_bool traceEnabled;
+
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer *buffers;            // every thread that has emitted, newest first
+static int threadCount;
+static uint64_t startNs;
+static char tracePath[256];
+static _Thread_local TraceBuffer *threadBuffer;
+
+static TraceChunk *NewChunk(void)
+{
+    TraceChunk *chunk = malloc(sizeof(TraceChunk));
+    if (chunk == NULL) return NULL;
+    atomic_init(&chunk->count, 0);
+    atomic_init(&chunk->next, NULL);
+    return chunk;
+}
+
+static TraceBuffer *ThreadBuffer(void)
+{
+    if (threadBuffer != NULL) return threadBuffer;
+
+    TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL) return NULL;
+    buffer->first = buffer->last = NewChunk();
+    if (buffer->first == NULL) {
+        free(buffer);
+        return NULL;
+    }
+    buffer->chunks = 1;
+    atomic_init(&buffer->dropped, 0);
+
+    pthread_mutex_lock(&registryLock);
+    buffer->tid = ++threadCount;
+    snprintf(buffer->name, sizeof(buffer->name), "thread %d", buffer->tid);
+    buffer->next = buffers;
+    buffers = buffer;
+    pthread_mutex_unlock(&registryLock);
+
+    threadBuffer = buffer;
+    return buffer;
+}
+
+void TraceEmit(char phase, const char *name, long long value)
+{
+    TraceBuffer *buffer = ThreadBuffer();
+    if (buffer == NULL) return;
+
+    TraceChunk *chunk = buffer->last;
+    int count = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+    if (count == TRACE_CHUNK_EVENTS) {
+        TraceChunk *next = buffer->chunks < TRACE_MAX_CHUNKS ? NewChunk() : NULL;
+        if (next == NULL) {
+            atomic_fetch_add_explicit(&buffer->dropped, 1, memory_order_relaxed);
+            return;
+        }
+        atomic_store_explicit(&chunk->next, next, memory_order_release);
+        buffer->last = chunk = next;
+        buffer->chunks++;
+        count = 0;
+    }
+
+    TraceEvent *event = &chunk->events[count];
+    event->name = name;
+    event->ns = TimerNowNs();
+    event->value = value;
+    event->phase = phase;
+    atomic_store_explicit(&chunk->count, count + 1, memory_order_release);
+}
+
+static void FlushAtExit(void)
+{
+    TraceFlush();
+}
+
+void TraceStart(const char *path)
+{
+    snprintf(tracePath, sizeof(tracePath), "%s", path);
+    if (startNs == 0) {
+        startNs = TimerNowNs();
+        atexit(FlushAtExit);
+    }
+    atomic_store(&traceEnabled, true);
+}
+
+void TraceThreadName(const char *name)
+{
+    if (!TraceEnabled()) return;
+    TraceBuffer *buffer = ThreadBuffer();
+    if (buffer == NULL) return;
+    pthread_mutex_lock(&registryLock);
+    snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    pthread_mutex_unlock(&registryLock);
+}
+
+// Event names are code literals, but keep the JSON valid whatever they hold
+static void WriteString(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        if ((unsigned char)*c >= 0x20) fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool TraceFlush(void)
+{
+    if (tracePath[0] == '\0') return false;
+    FILE *file = fopen(tracePath, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error writing %s!\n", tracePath);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    long long events = 0, dropped = 0;
+
+    pthread_mutex_lock(&registryLock);
+    for (TraceBuffer *buffer = buffers; buffer != NULL; buffer = buffer->next) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", buffer->tid);
+        WriteString(file, buffer->name);
+        fprintf(file, "}}");
+        first = false;
+
+        for (TraceChunk *chunk = buffer->first; chunk != NULL; chunk = atomic_load_explicit(&chunk->next, memory_order_acquire)) {
+            int count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for (int i = 0; i < count; i++) {
+                const TraceEvent *event = &chunk->events[i];
+                double ts = event->ns > startNs ? (double)(event->ns - startNs) / 1000.0 : 0.0;
+                fprintf(file, ",\n{\"name\":");
+                WriteString(file, event->name);
+                fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d", event->phase, ts, buffer->tid);
+                if (event->phase == 'C') fprintf(file, ",\"args\":{\"value\":%lld}", event->value);
+                if (event->phase == 'i') fprintf(file, ",\"s\":\"t\"");
+                fprintf(file, "}");
+            }
+            events += count;
+        }
+        dropped += atomic_load_explicit(&buffer->dropped, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&registryLock);
+
+    fprintf(file, "\n]}\n");
+    bool ok = fclose(file) == 0;
+    fprintf(stderr, "Trace: %lld events written to %s", events, tracePath);
+    if (dropped > 0) fprintf(stderr, ", %lld dropped", dropped);
+    fputc('\n', stderr);
+    return ok;
+}
@@ -0,0 +1,40 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Event tracing in the Chrome trace format (chrome://tracing, Perfetto).
+// Every thread appends begin/end, instant and counter events to its own
+// buffer, so recording takes no lock; the buffers are written out as one
+// JSON file on exit or on demand. With tracing off, each TRACE_* costs one
+// relaxed load and a branch.
+//
+// Event names must be string literals (or otherwise outlive the trace):
+// only the pointer is stored.
+
+#define TRACE_CHUNK_EVENTS 16384
+#define TRACE_MAX_CHUNKS 64          // per thread; events past that are counted and dropped
+
+extern atomic_bool traceEnabled;
+
+static inline bool TraceEnabled(void) { return atomic_load_explicit(&traceEnabled, memory_order_relaxed); }
+
+// phase is 'B' (begin), 'E' (end), 'i' (instant) or 'C' (counter, with value)
+void TraceEmit(char phase, const char *name, long long value);
+
+#define TRACE_BEGIN(name) do { if (TraceEnabled()) TraceEmit('B', (name), 0); } while (0)
+#define TRACE_END(name) do { if (TraceEnabled()) TraceEmit('E', (name), 0); } while (0)
+#define TRACE_INSTANT(name) do { if (TraceEnabled()) TraceEmit('i', (name), 0); } while (0)
+#define TRACE_COUNTER(name, value) do { if (TraceEnabled()) TraceEmit('C', (name), (long long)(value)); } while (0)
+
+// Turns tracing on; TraceFlush and process exit write to path
+void TraceStart(const char *path);
+
+// Names the calling thread in the trace viewer
+void TraceThreadName(const char *name);
+
+// Writes everything recorded so far, from every thread
+bool TraceFlush(void);
+
+#endif // TRACE_H
@@ -0,0 +1,42 @@
+#include "widget.h"
+#include <string.h>
+
+static int CellIndex(float position, float cellSize)
+{
+    int index = (int)(position / cellSize);
+    if (index < 0) return 0;
+    if (index >= WIDGET_GRID) return WIDGET_GRID - 1;
+    return index;
+}
+
+void WidgetTableInit(WidgetTable *table, const Widget *widgets, int count, float width, float height)
+{
+    memset(table, 0, sizeof(*table));
+    table->widgets = widgets;
+    table->count = count < WIDGET_MAX ? count : WIDGET_MAX;
+    table->cellWidth = width / WIDGET_GRID;
+    table->cellHeight = height / WIDGET_GRID;
+
+    for (int i = 0; i < table->count; i++) {
+        Rectangle bounds = widgets[i].bounds;
+        int left = CellIndex(bounds.x, table->cellWidth);
+        int right = CellIndex(bounds.x + bounds.width, table->cellWidth);
+        int top = CellIndex(bounds.y, table->cellHeight);
+        int bottom = CellIndex(bounds.y + bounds.height, table->cellHeight);
+        for (int row = top; row <= bottom; row++) {
+            for (int col = left; col <= right; col++) table->cells[row][col] |= 1u << i;
+        }
+    }
+}
+
+const Widget *WidgetTableHit(const WidgetTable *table, Vector2 point)
+{
+    if (point.x < 0 || point.y < 0) return NULL;
+    uint32_t candidates = table->cells[CellIndex(point.y, table->cellHeight)][CellIndex(point.x, table->cellWidth)];
+    while (candidates != 0) {
+        int i = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        if (CheckCollisionPointRec(point, table->widgets[i].bounds)) return &table->widgets[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include "raylib.h"
+#include <stdint.h>
+
+// Retained widgets: each screen's buttons are listed once, with their
+// bounds and flags, and both the input handlers and the draw code read the
+// same table. A table also buckets its widgets into a coarse grid over the
+// screen, so finding the widget under the mouse only tests the few whose
+// bounds touch the mouse's grid cell.
+
+#define WIDGET_GRID 8           // grid cells per side
+#define WIDGET_MAX 32           // per table, one bit each in a grid cell
+
+#define WIDGET_VIBRATES 1       // jiggles while hovered
+
+typedef struct {
+    int id;
+    Rectangle bounds;
+    const char *label;
+    int fontSize;
+    unsigned flags;
+} Widget;
+
+typedef struct {
+    const Widget *widgets;
+    int count;
+    float cellWidth;
+    float cellHeight;
+    uint32_t cells[WIDGET_GRID][WIDGET_GRID];  // which widgets overlap each cell
+} WidgetTable;
+
+void WidgetTableInit(WidgetTable *table, const Widget *widgets, int count, float width, float height);
+
+// The widget under the point, NULL if there is none
+const Widget *WidgetTableHit(const WidgetTable *table, Vector2 point);
+
+#endif // WIDGET_H